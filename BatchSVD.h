@@ -0,0 +1,820 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   This file implements a batched 3D SVD on structure-of-arrays data.
+
+   The same implicit QR iteration as ImplicitQRSVD.h runs on all the lanes of a
+   SIMD register at once. Lanes that converge early are masked out, and lanes
+   that have not converged after max_qr_iterations are finished by the scalar
+   version. The degenerate cases, the 2x2 cleanup and the sorting are done with
+   per-lane selects, so the output follows the same sign and sorting
+   conventions as the scalar version.
+
+   T may be float or double.
+
+   A matrix stream k holds entry (k % 3, k / 3) of every matrix, i.e. the
+   streams are in Eigen's column major order.
+
+   JIXIE::MatrixStreams<T, 3, 3> A(n), U(n), V(n);
+   JIXIE::MatrixStreams<T, 3, 1> sigma(n);
+   A.set(i, some_matrix); ...
+   JIXIE::batchSingularValueDecomposition(n, A.streams(), U.streams(), sigma.streams(), V.streams());
+   // A.get(i) = U.get(i) * sigma.get(i).asDiagonal() * V.get(i).transpose()
+   ################################################################################
+*/
+
+#ifndef JIXIE_BATCH_SVD_H
+#define JIXIE_BATCH_SVD_H
+
+#include "ImplicitQRSVD.h"
+#include "SimdPack.h"
+#include "SVDStatistics.h"
+#include <algorithm>
+#include <vector>
+
+namespace JIXIE {
+
+/**
+   Owning structure-of-arrays storage for n matrices of size Rows x Cols.
+*/
+template <class T, int Rows, int Cols>
+class MatrixStreams {
+public:
+    static constexpr int Size = Rows * Cols;
+
+    MatrixStreams(size_t n = 0)
+    {
+        resize(n);
+    }
+
+    void resize(size_t n)
+    {
+        count = n;
+        data.resize(Size * n);
+        for (int k = 0; k < Size; k++)
+            pointers[k] = data.data() + k * n;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    T* const* streams()
+    {
+        return pointers;
+    }
+
+    const T* const* streams() const
+    {
+        return pointers;
+    }
+
+    void set(size_t i, const Eigen::Matrix<T, Rows, Cols>& M)
+    {
+        for (int k = 0; k < Size; k++)
+            pointers[k][i] = M(k);
+    }
+
+    Eigen::Matrix<T, Rows, Cols> get(size_t i) const
+    {
+        Eigen::Matrix<T, Rows, Cols> M;
+        for (int k = 0; k < Size; k++)
+            M(k) = pointers[k][i];
+        return M;
+    }
+
+private:
+    size_t count;
+    std::vector<T> data;
+    T* pointers[Size];
+};
+
+namespace SIMD {
+
+/**
+   3x3 matrix of packs, column major like Eigen.
+*/
+template <class P>
+struct Matrix3 {
+    using Vec = typename P::Vec;
+    Vec m[9];
+
+    inline Vec& operator()(int i, int j) { return m[i + 3 * j]; }
+    inline const Vec& operator()(int i, int j) const { return m[i + 3 * j]; }
+
+    inline void setIdentity()
+    {
+        for (int k = 0; k < 9; k++)
+            m[k] = P::broadcast((k % 4 == 0) ? 1 : 0);
+    }
+
+    inline void swapColumns(const typename P::Mask mask, int i, int k)
+    {
+        for (int j = 0; j < 3; j++) {
+            Vec a = (*this)(j, i);
+            Vec b = (*this)(j, k);
+            (*this)(j, i) = P::select(mask, b, a);
+            (*this)(j, k) = P::select(mask, a, b);
+        }
+    }
+
+    inline void negateColumn(const typename P::Mask mask, int i)
+    {
+        for (int j = 0; j < 3; j++)
+            (*this)(j, i) = P::select(mask, -(*this)(j, i), (*this)(j, i));
+    }
+};
+
+/**
+   Lane wise version of JIXIE::GivensRotation with compile time rows.
+   mask() turns the rotation into the identity on the lanes that should not change,
+   which leaves their data bit for bit untouched.
+*/
+template <class P, int rowi, int rowk>
+class GivensRotation {
+public:
+    using Vec = typename P::Vec;
+    using Mask = typename P::Mask;
+    Vec c;
+    Vec s;
+
+    inline GivensRotation()
+        : c(P::broadcast(1))
+        , s(P::broadcast(0))
+    {
+    }
+
+    inline GivensRotation(const Vec a, const Vec b)
+    {
+        compute(a, b);
+    }
+
+    /**
+       Compute c and s from a and b so that
+       ( c -s ) ( a )  =  ( * )
+       s  c     b       ( 0 )
+    */
+    inline void compute(const Vec a, const Vec b)
+    {
+        Vec d = a * a + b * b;
+        Mask nonzero = d != 0;
+        Vec t = 1 / P::sqrt(P::select(nonzero, d, P::broadcast(1)));
+        c = P::select(nonzero, a * t, P::broadcast(1));
+        s = P::select(nonzero, -b * t, P::broadcast(0));
+    }
+
+    /**
+       This function computes c and s so that
+       ( c -s ) ( a )  =  ( 0 )
+       s  c     b       ( * )
+    */
+    inline void computeUnconventional(const Vec a, const Vec b)
+    {
+        Vec d = a * a + b * b;
+        Mask nonzero = d != 0;
+        Vec t = 1 / P::sqrt(P::select(nonzero, d, P::broadcast(1)));
+        s = P::select(nonzero, a * t, P::broadcast(1));
+        c = P::select(nonzero, b * t, P::broadcast(0));
+    }
+
+    inline void mask(const Mask m)
+    {
+        c = P::select(m, c, P::broadcast(1));
+        s = P::select(m, s, P::broadcast(0));
+    }
+
+    inline void rowRotation(Matrix3<P>& A) const
+    {
+        for (int j = 0; j < 3; j++) {
+            Vec tau1 = A(rowi, j);
+            Vec tau2 = A(rowk, j);
+            A(rowi, j) = c * tau1 - s * tau2;
+            A(rowk, j) = s * tau1 + c * tau2;
+        }
+    }
+
+    inline void columnRotation(Matrix3<P>& A) const
+    {
+        for (int j = 0; j < 3; j++) {
+            Vec tau1 = A(j, rowi);
+            Vec tau2 = A(j, rowk);
+            A(j, rowi) = c * tau1 - s * tau2;
+            A(j, rowk) = s * tau1 + c * tau2;
+        }
+    }
+};
+
+/**
+   \brief Lane wise JIXIE::zeroChase, only applied on the lanes in active
+*/
+template <class P>
+inline void zeroChase(Matrix3<P>& H, Matrix3<P>& U, Matrix3<P>& V, const typename P::Mask active)
+{
+    using Vec = typename P::Vec;
+    GivensRotation<P, 0, 1> r1(H(0, 0), H(1, 0));
+    typename P::Mask h10_nonzero = H(1, 0) != 0;
+    Vec a = P::select(h10_nonzero, H(0, 0) * H(0, 1) + H(1, 0) * H(1, 1), H(0, 1));
+    Vec b = P::select(h10_nonzero, H(0, 0) * H(0, 2) + H(1, 0) * H(1, 2), H(0, 2));
+    GivensRotation<P, 1, 2> r2(a, b);
+    r1.mask(active);
+    r2.mask(active);
+
+    r1.rowRotation(H);
+    r2.columnRotation(H);
+    r2.columnRotation(V);
+
+    GivensRotation<P, 1, 2> r3(H(1, 1), H(2, 1));
+    r3.mask(active);
+    r3.rowRotation(H);
+
+    r1.columnRotation(U);
+    r3.columnRotation(U);
+}
+
+/**
+   \brief Lane wise JIXIE::makeUpperBidiag
+*/
+template <class P>
+inline void makeUpperBidiag(Matrix3<P>& H, Matrix3<P>& U, Matrix3<P>& V)
+{
+    U.setIdentity();
+    V.setIdentity();
+
+    GivensRotation<P, 1, 2> r(H(1, 0), H(2, 0));
+    r.rowRotation(H);
+    r.columnRotation(U);
+    zeroChase(H, U, V, P::broadcast(0) == 0);
+}
+
+/**
+   \brief Lane wise JIXIE::wilkinsonShift
+*/
+template <class P>
+inline typename P::Vec wilkinsonShift(const typename P::Vec a1, const typename P::Vec b1, const typename P::Vec a2)
+{
+    using Vec = typename P::Vec;
+    Vec d = (typename P::Scalar)0.5 * (a1 - a2);
+    Vec bs = b1 * b1;
+    return a2 - P::copysign(bs / (P::abs(d) + P::sqrt(d * d + bs)), d);
+}
+
+/**
+   \brief Lane wise JIXIE::bidiagonalQRStep, only applied on the lanes in active.
+   Like the scalar version the upper bidiagonal matrix is held in alpha_1, beta_1, alpha_2, beta_2,
+   alpha_3 and the entries that are zero in exact arithmetic are never formed, but the rotations
+   are applied to U and V right away.
+*/
+template <class P>
+inline void bidiagonalQRStep(typename P::Vec& alpha_1, typename P::Vec& beta_1, typename P::Vec& alpha_2,
+    typename P::Vec& beta_2, typename P::Vec& alpha_3, const typename P::Vec mu,
+    Matrix3<P>& U, Matrix3<P>& V, const typename P::Mask active)
+{
+    using Vec = typename P::Vec;
+
+    // Column rotation by the shift
+    GivensRotation<P, 0, 1> r(alpha_1 * alpha_1 - mu, alpha_1 * beta_1);
+    Vec h00 = r.c * alpha_1 - r.s * beta_1;
+    Vec h01 = r.s * alpha_1 + r.c * beta_1;
+    Vec h10 = -r.s * alpha_2;
+    Vec h11 = r.c * alpha_2;
+
+    // Same rotations as zeroChase, r2 is computed without multiplying by r1
+    GivensRotation<P, 0, 1> r1(h00, h10);
+    typename P::Mask h10_nonzero = h10 != 0;
+    GivensRotation<P, 1, 2> r2(P::select(h10_nonzero, h00 * h01 + h10 * h11, h01),
+        P::select(h10_nonzero, h10 * beta_2, P::broadcast(0)));
+
+    // Row rotation r1 leaves the bulge in (0,2)
+    Vec a1 = r1.c * h00 - r1.s * h10;
+    Vec g01 = r1.c * h01 - r1.s * h11;
+    Vec bulge = -r1.s * beta_2;
+    Vec g11 = r1.s * h01 + r1.c * h11;
+    Vec g12 = r1.c * beta_2;
+
+    // Column rotation r2 moves the bulge to (2,1)
+    Vec b1 = r2.c * g01 - r2.s * bulge;
+    Vec k11 = r2.c * g11 - r2.s * g12;
+    Vec k12 = r2.s * g11 + r2.c * g12;
+    bulge = -r2.s * alpha_3;
+    Vec k22 = r2.c * alpha_3;
+
+    // Row rotation r3 removes it
+    GivensRotation<P, 1, 2> r3(k11, bulge);
+    alpha_1 = P::select(active, a1, alpha_1);
+    beta_1 = P::select(active, b1, beta_1);
+    alpha_2 = P::select(active, r3.c * k11 - r3.s * bulge, alpha_2);
+    beta_2 = P::select(active, r3.c * k12 - r3.s * k22, beta_2);
+    alpha_3 = P::select(active, r3.s * k12 + r3.c * k22, alpha_3);
+
+    r.mask(active);
+    r1.mask(active);
+    r2.mask(active);
+    r3.mask(active);
+    r1.columnRotation(U);
+    r3.columnRotation(U);
+    r.columnRotation(V);
+    r2.columnRotation(V);
+}
+
+/**
+   \brief Lane wise version of process<0> and process<1>.
+   Lanes in t1 are processed like process<1>, the others like process<0>.
+   The 2x2 SVD is the same as the 2x2 JIXIE::singularValueDecomposition.
+*/
+template <class P>
+inline void process(const typename P::Mask t1, Matrix3<P>& B, Matrix3<P>& U, typename P::Vec sigma[3], Matrix3<P>& V)
+{
+    using Vec = typename P::Vec;
+    using Mask = typename P::Mask;
+    using T = typename P::Scalar;
+
+    Vec x00 = P::select(t1, B(1, 1), B(0, 0));
+    Vec x01 = P::select(t1, B(1, 2), B(0, 1));
+    Vec x10 = P::select(t1, B(2, 1), B(1, 0));
+    Vec x11 = P::select(t1, B(2, 2), B(1, 1));
+    Vec other = P::select(t1, B(0, 0), B(2, 2));
+
+    // 2x2 polar decomposition
+    Vec p0 = x00 + x11;
+    Vec p1 = x10 - x01;
+    Vec denominator = P::sqrt(p0 * p0 + p1 * p1);
+    Mask nonzero = denominator != 0;
+    Vec safe_denominator = P::select(nonzero, denominator, P::broadcast(1));
+    Vec uc = P::select(nonzero, p0 / safe_denominator, P::broadcast(1));
+    Vec us = P::select(nonzero, -p1 / safe_denominator, P::broadcast(0));
+    Vec x = uc * x00 - us * x10;
+    Vec y = uc * x01 - us * x11;
+    Vec z = us * x01 + uc * x11;
+
+    // 2x2 symmetric eigenproblem
+    Mask diagonal = y == 0;
+    Vec tau = (T)0.5 * (x - z);
+    Vec w = P::sqrt(tau * tau + y * y);
+    Vec t = y / P::select(tau > 0, tau + w, tau - w);
+    Vec cosine = 1 / P::sqrt(t * t + 1);
+    Vec sine = -t * cosine;
+    cosine = P::select(diagonal, P::broadcast(1), cosine);
+    sine = P::select(diagonal, P::broadcast(0), sine);
+    Vec c2 = cosine * cosine;
+    Vec csy = 2 * cosine * sine * y;
+    Vec s2 = sine * sine;
+    Vec sigma0 = P::select(diagonal, x, c2 * x - csy + s2 * z);
+    Vec sigma1 = P::select(diagonal, z, s2 * x + csy + c2 * z);
+
+    // 2x2 sorting
+    Mask swap = sigma0 < sigma1;
+    Vec tmp = sigma0;
+    sigma0 = P::select(swap, sigma1, sigma0);
+    sigma1 = P::select(swap, tmp, sigma1);
+    Vec vc = P::select(swap, -sine, cosine);
+    Vec vs = P::select(swap, cosine, sine);
+    Vec new_uc = uc * vc - us * vs;
+    Vec new_us = us * vc + uc * vs;
+
+    GivensRotation<P, 0, 1> u01, v01;
+    GivensRotation<P, 1, 2> u12, v12;
+    u01.c = u12.c = new_uc;
+    u01.s = u12.s = new_us;
+    v01.c = v12.c = vc;
+    v01.s = v12.s = vs;
+    u01.mask(~t1);
+    v01.mask(~t1);
+    u12.mask(t1);
+    v12.mask(t1);
+    u01.columnRotation(U);
+    u12.columnRotation(U);
+    v01.columnRotation(V);
+    v12.columnRotation(V);
+
+    sigma[0] = P::select(t1, other, sigma0);
+    sigma[1] = P::select(t1, sigma0, sigma1);
+    sigma[2] = P::select(t1, sigma1, other);
+}
+
+/**
+   \brief Lane wise flipSign, only on the lanes in mask
+*/
+template <class P>
+inline void flipSign(const typename P::Mask mask, int i, Matrix3<P>& U, typename P::Vec sigma[3])
+{
+    sigma[i] = P::select(mask, -sigma[i], sigma[i]);
+    U.negateColumn(mask, i);
+}
+
+template <class P>
+inline void swapSigma(const typename P::Mask mask, int i, int k, typename P::Vec sigma[3])
+{
+    typename P::Vec a = sigma[i];
+    sigma[i] = P::select(mask, sigma[k], a);
+    sigma[k] = P::select(mask, a, sigma[k]);
+}
+
+/**
+   \brief Lane wise sort<0> applied on the lanes in t0
+*/
+template <class P>
+inline void sort0(const typename P::Mask t0, Matrix3<P>& U, typename P::Vec sigma[3], Matrix3<P>& V, const typename P::Mask valid)
+{
+    using Mask = typename P::Mask;
+
+    // Case: sigma(0) > |sigma(1)| >= |sigma(2)|
+    Mask done = t0 & (P::abs(sigma[1]) >= P::abs(sigma[2]));
+    Mask rest = t0 & ~done;
+
+    // fix sign of sigma for all cases
+    Mask flip = (done & (sigma[1] < 0)) | (rest & (sigma[2] < 0));
+    flipSign<P>(flip, 1, U, sigma);
+    flipSign<P>(flip, 2, U, sigma);
+
+    //swap sigma(1) and sigma(2) for both cases
+    swapSigma<P>(rest, 1, 2, sigma);
+    U.swapColumns(rest, 1, 2);
+    V.swapColumns(rest, 1, 2);
+
+    // Case: |sigma(2)| >= sigma(0) > |simga(1)|
+    Mask swap = rest & (sigma[1] > sigma[0]);
+    swapSigma<P>(swap, 0, 1, sigma);
+    U.swapColumns(swap, 0, 1);
+    V.swapColumns(swap, 0, 1);
+
+    // Case: sigma(0) >= |sigma(2)| > |simga(1)|
+    Mask negate = rest & ~swap;
+    U.negateColumn(negate, 2);
+    V.negateColumn(negate, 2);
+
+    STATISTICS::recordSortCase<P::Width>(STATISTICS::Sort0InOrder, done & valid);
+    STATISTICS::recordSortCase<P::Width>(STATISTICS::Sort0MoveLastToFront, swap & valid);
+    STATISTICS::recordSortCase<P::Width>(STATISTICS::Sort0SwapLastTwo, negate & valid);
+}
+
+/**
+   \brief Lane wise sort<1> applied on the lanes in t1
+*/
+template <class P>
+inline void sort1(const typename P::Mask t1, Matrix3<P>& U, typename P::Vec sigma[3], Matrix3<P>& V, const typename P::Mask valid)
+{
+    using Mask = typename P::Mask;
+
+    // Case: |sigma(0)| >= sigma(1) > |sigma(2)|
+    Mask done = t1 & (P::abs(sigma[0]) >= sigma[1]);
+    Mask rest = t1 & ~done;
+    Mask flip = done & (sigma[0] < 0);
+    flipSign<P>(flip, 0, U, sigma);
+    flipSign<P>(flip, 2, U, sigma);
+
+    //swap sigma(0) and sigma(1) for both cases
+    swapSigma<P>(rest, 0, 1, sigma);
+    U.swapColumns(rest, 0, 1);
+    V.swapColumns(rest, 0, 1);
+
+    // Case: sigma(1) > |sigma(2)| >= |sigma(0)|
+    Mask swap = rest & (P::abs(sigma[1]) < P::abs(sigma[2]));
+    swapSigma<P>(swap, 1, 2, sigma);
+    U.swapColumns(swap, 1, 2);
+    V.swapColumns(swap, 1, 2);
+
+    // Case: sigma(1) >= |sigma(0)| > |sigma(2)|
+    Mask negate = rest & ~swap;
+    U.negateColumn(negate, 1);
+    V.negateColumn(negate, 1);
+
+    // fix sign for both cases
+    flip = rest & (sigma[1] < 0);
+    flipSign<P>(flip, 1, U, sigma);
+    flipSign<P>(flip, 2, U, sigma);
+
+    STATISTICS::recordSortCase<P::Width>(STATISTICS::Sort1InOrder, done & valid);
+    STATISTICS::recordSortCase<P::Width>(STATISTICS::Sort1MoveFirstToBack, swap & valid);
+    STATISTICS::recordSortCase<P::Width>(STATISTICS::Sort1SwapFirstTwo, negate & valid);
+}
+
+/**
+   Lanes that need more QR iterations than this are left to the scalar JIXIE::singularValueDecomposition,
+   so that a hard lane does not hold up the other lanes of its pack
+*/
+constexpr int max_qr_iterations = 16;
+
+/**
+   \brief Lane wise 3X3 SVD, see JIXIE::singularValueDecomposition.
+   Only the lanes in valid are counted by the statistics of SVDStatistics.h.
+   \return number of QR iterations of every lane, including those of the scalar kernel for the lanes
+   that did not converge within max_qr_iterations
+*/
+template <class P>
+inline typename P::Vec singularValueDecomposition(const Matrix3<P>& A,
+    Matrix3<P>& U,
+    typename P::Vec sigma[3],
+    Matrix3<P>& V,
+    typename P::Scalar tolerance,
+    const typename P::Mask valid = P::broadcast(0) == P::broadcast(0))
+{
+    using Vec = typename P::Vec;
+    using Mask = typename P::Mask;
+    using T = typename P::Scalar;
+
+    // Nonzero lanes whose largest entry is outside JIXIE::SafeScale are left to the scalar kernel, which scales them
+    Vec m = P::abs(A.m[0]);
+    for (int k = 1; k < 9; k++)
+        m = P::select(P::abs(A.m[k]) > m, P::abs(A.m[k]), m);
+    Mask unsafe = valid & ~(m == P::broadcast(0))
+        & ~((m >= P::broadcast(SafeScale<T>::lower)) & (m <= P::broadcast(SafeScale<T>::upper)));
+
+    Matrix3<P> B = A;
+    makeUpperBidiag(B, U, V);
+
+    Vec count = P::broadcast(0);
+    Vec alpha_1 = B(0, 0);
+    Vec beta_1 = B(0, 1);
+    Vec alpha_2 = B(1, 1);
+    Vec alpha_3 = B(2, 2);
+    Vec beta_2 = B(1, 2);
+    Vec gamma_2 = alpha_2 * beta_2;
+    Vec norm = (T)0.5 * P::sqrt(alpha_1 * alpha_1 + alpha_2 * alpha_2 + alpha_3 * alpha_3 + beta_1 * beta_1 + beta_2 * beta_2);
+    Vec floor = P::broadcast(std::numeric_limits<T>::min());
+    Vec tol = tolerance * P::select(norm > floor, norm, floor);
+
+    /**
+       Do implicit shift QR until A^T A is block diagonal
+    */
+    Mask active = (P::abs(beta_2) > tol) & (P::abs(beta_1) > tol)
+        & (P::abs(alpha_1) > tol) & (P::abs(alpha_2) > tol)
+        & (P::abs(alpha_3) > tol) & ~unsafe;
+    for (int k = 0; k < max_qr_iterations && P::any(active); k++) {
+        Vec mu = wilkinsonShift<P>(alpha_2 * alpha_2 + beta_1 * beta_1, gamma_2, alpha_3 * alpha_3 + beta_2 * beta_2);
+        bidiagonalQRStep<P>(alpha_1, beta_1, alpha_2, beta_2, alpha_3, mu, U, V, active);
+        gamma_2 = alpha_2 * beta_2;
+        count = P::select(active, count + 1, count);
+        active &= (P::abs(beta_2) > tol) & (P::abs(beta_1) > tol)
+            & (P::abs(alpha_1) > tol) & (P::abs(alpha_2) > tol)
+            & (P::abs(alpha_3) > tol);
+    }
+    Mask stuck = active | unsafe;
+    Mask counted = valid & ~stuck;
+
+    // Like the scalar version, the round-off below the bidiagonal of makeUpperBidiag is dropped
+    for (int k = 0; k < 9; k++)
+        B.m[k] = P::broadcast(0);
+    B(0, 0) = alpha_1;
+    B(0, 1) = beta_1;
+    B(1, 1) = alpha_2;
+    B(1, 2) = beta_2;
+    B(2, 2) = alpha_3;
+
+    /**
+       Classify the lanes the same way as the if-else chain of the scalar version
+    */
+    Mask small_beta_2 = P::abs(beta_2) <= tol;
+    Mask small_beta_1 = ~small_beta_2 & (P::abs(beta_1) <= tol);
+    Mask rest = ~(small_beta_2 | small_beta_1);
+    Mask small_alpha_2 = rest & (P::abs(alpha_2) <= tol);
+    rest &= ~small_alpha_2;
+    Mask small_alpha_3 = rest & (P::abs(alpha_3) <= tol);
+    rest &= ~small_alpha_3;
+    Mask small_alpha_1 = rest & (P::abs(alpha_1) <= tol);
+    STATISTICS::recordIterations<P::Width>(count, counted);
+    STATISTICS::recordBranch<P::Width>(STATISTICS::SmallBeta2, small_beta_2 & counted);
+    STATISTICS::recordBranch<P::Width>(STATISTICS::SmallBeta1, small_beta_1 & counted);
+    STATISTICS::recordBranch<P::Width>(STATISTICS::SmallAlpha2, small_alpha_2 & counted);
+    STATISTICS::recordBranch<P::Width>(STATISTICS::SmallAlpha3, small_alpha_3 & counted);
+    STATISTICS::recordBranch<P::Width>(STATISTICS::SmallAlpha1, small_alpha_1 & counted);
+
+    /**
+       alpha_2 small: reduce B to
+       x x 0
+       0 0 0
+       0 0 x
+    */
+    {
+        GivensRotation<P, 1, 2> r1;
+        r1.computeUnconventional(B(1, 2), B(2, 2));
+        r1.mask(small_alpha_2);
+        r1.rowRotation(B);
+        r1.columnRotation(U);
+    }
+    /**
+       alpha_3 small: reduce B to
+       x x 0
+       + x 0
+       0 0 0
+    */
+    {
+        GivensRotation<P, 1, 2> r1(B(1, 1), B(1, 2));
+        r1.mask(small_alpha_3);
+        r1.columnRotation(B);
+        r1.columnRotation(V);
+        GivensRotation<P, 0, 2> r2(B(0, 0), B(0, 2));
+        r2.mask(small_alpha_3);
+        r2.columnRotation(B);
+        r2.columnRotation(V);
+    }
+    /**
+       alpha_1 small: reduce B to
+       0 0 0
+       0 x x
+       0 + x
+    */
+    {
+        GivensRotation<P, 0, 1> r1;
+        r1.computeUnconventional(B(0, 1), B(1, 1));
+        r1.mask(small_alpha_1);
+        r1.rowRotation(B);
+        r1.columnRotation(U);
+        GivensRotation<P, 0, 2> r2;
+        r2.computeUnconventional(B(0, 2), B(2, 2));
+        r2.mask(small_alpha_1);
+        r2.rowRotation(B);
+        r2.columnRotation(U);
+    }
+
+    Mask t1 = small_beta_1 | small_alpha_1;
+    process<P>(t1, B, U, sigma, V);
+    sort0<P>(~t1, U, sigma, V, counted);
+    sort1<P>(t1, U, sigma, V, counted);
+
+    if (P::any(stuck))
+        for (int l = 0; l < P::Width; l++) {
+            if (!stuck[l])
+                continue;
+            Eigen::Matrix<T, 3, 3> a, u, v;
+            Eigen::Matrix<T, 3, 1> s;
+            for (int k = 0; k < 9; k++)
+                a(k) = A.m[k][l];
+            count[l] += JIXIE::singularValueDecomposition(a, u, s, v, tolerance);
+            for (int k = 0; k < 9; k++) {
+                U.m[k][l] = u(k);
+                V.m[k][l] = v(k);
+            }
+            for (int k = 0; k < 3; k++)
+                sigma[k][l] = s(k);
+        }
+
+    return count;
+}
+
+/**
+   \brief Shared driver of the batched polar decompositions A = R S on structure-of-arrays data, see
+   batchIterativePolarDecomposition and batchSmallStrainPolarDecomposition.
+   \param[in] kernel kernel(a, r, s) decomposes the lanes of a into r and s, s in the order of
+   SymmetricMatrix3, and returns a count per lane, -1 on the lanes whose r and s are garbage.
+
+   The lanes with count -1 go through the scalar polarDecomposition after their pack.
+   The last n % W matrices are padded with identities.
+*/
+template <class P, class Kernel>
+inline void batchPolarDecomposition(const size_t n,
+    const typename P::Scalar* const A[9],
+    typename P::Scalar* const R[9],
+    typename P::Scalar* const S[6],
+    int* count,
+    Kernel kernel)
+{
+    using T = typename P::Scalar;
+    using Vec = typename P::Vec;
+    using Mask = typename P::Mask;
+    constexpr int W = P::Width;
+
+    Matrix3<P> a, r;
+    Vec s[6];
+    for (size_t i = 0; i < n; i += W) {
+        const size_t lanes = std::min<size_t>(W, n - i);
+        if (lanes == W)
+            for (int k = 0; k < 9; k++)
+                a.m[k] = P::load(A[k] + i);
+        else {
+            // padded with identities
+            a.setIdentity();
+            for (int k = 0; k < 9; k++)
+                for (size_t l = 0; l < lanes; l++)
+                    a.m[k][l] = A[k][i + l];
+        }
+        Vec c = kernel(a, r, s);
+        Mask fallback = c < P::broadcast(0);
+        if (P::any(fallback) || count) {
+            for (size_t l = 0; l < lanes; l++) {
+                if (fallback[l]) {
+                    Eigen::Matrix<T, 3, 3> A_l, R_l;
+                    SymmetricMatrix3<T> S_l;
+                    for (int k = 0; k < 9; k++)
+                        A_l(k) = A[k][i + l];
+                    polarDecomposition(A_l, R_l, S_l);
+                    for (int k = 0; k < 9; k++)
+                        r.m[k][l] = R_l(k);
+                    for (int k = 0; k < 6; k++)
+                        s[k][l] = S_l.data[k];
+                }
+                if (count)
+                    count[i + l] = (int)c[l];
+            }
+        }
+        if (lanes == W) {
+            for (int k = 0; k < 9; k++)
+                P::store(R[k] + i, r.m[k]);
+            for (int k = 0; k < 6; k++)
+                P::store(S[k] + i, s[k]);
+        }
+        else {
+            for (size_t l = 0; l < lanes; l++) {
+                for (int k = 0; k < 9; k++)
+                    R[k][i + l] = r.m[k][l];
+                for (int k = 0; k < 6; k++)
+                    S[k][i + l] = s[k][l];
+            }
+        }
+    }
+}
+}
+
+/**
+   \brief Batched 3X3 SVD (singular value decomposition) A=USV' on structure-of-arrays data.
+   \param[in] n Number of matrices.
+   \param[in] A 9 input streams in column major order.
+   \param[out] U 9 output streams. Every U is a rotation matrix.
+   \param[out] sigma 3 output streams, sorted with decreasing magnitude. The third one can be negative.
+   \param[out] V 9 output streams. Every V is a rotation matrix.
+   \param[out] count Optional number of QR iterations per matrix.
+
+   W is the number of SIMD lanes and defaults to the widest enabled register.
+   The last n % W matrices are padded with identities.
+*/
+template <class T, int W = SIMD::NativeWidth<T>::value>
+inline void batchSingularValueDecomposition(const size_t n,
+    const T* const A[9],
+    T* const U[9],
+    T* const sigma[3],
+    T* const V[9],
+    int* count = nullptr,
+    const T tol = 128 * std::numeric_limits<T>::epsilon())
+{
+    using P = SIMD::Pack<T, W>;
+    using Vec = typename P::Vec;
+
+    SIMD::Matrix3<P> a, u, v;
+    Vec s[3];
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        for (int k = 0; k < 9; k++)
+            a.m[k] = P::load(A[k] + i);
+        Vec c = SIMD::singularValueDecomposition(a, u, s, v, tol);
+        for (int k = 0; k < 9; k++) {
+            P::store(U[k] + i, u.m[k]);
+            P::store(V[k] + i, v.m[k]);
+        }
+        for (int k = 0; k < 3; k++)
+            P::store(sigma[k] + i, s[k]);
+        if (count)
+            for (int l = 0; l < W; l++)
+                count[i + l] = (int)c[l];
+    }
+    if (i == n)
+        return;
+
+    size_t remainder = n - i;
+    typename P::Mask valid;
+    a.setIdentity();
+    for (size_t l = 0; l < W; l++)
+        valid[l] = l < remainder ? -1 : 0;
+    for (int k = 0; k < 9; k++)
+        for (size_t l = 0; l < remainder; l++)
+            a.m[k][l] = A[k][i + l];
+    Vec c = SIMD::singularValueDecomposition(a, u, s, v, tol, valid);
+    for (size_t l = 0; l < remainder; l++) {
+        for (int k = 0; k < 9; k++) {
+            U[k][i + l] = u.m[k][l];
+            V[k][i + l] = v.m[k][l];
+        }
+        for (int k = 0; k < 3; k++)
+            sigma[k][i + l] = s[k][l];
+        if (count)
+            count[i + l] = (int)c[l];
+    }
+}
+}
+#endif
@@ -0,0 +1,507 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   This file provides the pieces of a machine readable benchmark: key=value options
+   from the command line or a file, warm up and repeated measurements, outlier
+   rejection, confidence intervals, cpu pinning and text/CSV/JSON reports.
+
+   JIXIE::BENCHMARK::Options options(argc, argv); // e.g. ./a repeat=20 format=csv
+   JIXIE::BENCHMARK::Report report;
+   std::vector<double> seconds = JIXIE::BENCHMARK::measure(warmup, repeat, [&] { work(); });
+   JIXIE::BENCHMARK::Summary s = JIXIE::BENCHMARK::summarize(seconds, 3.5);
+   report.add().set("engine", "impQR").set("ns_per_matrix", s.mean / n * 1e9);
+   report.write(std::cout, JIXIE::BENCHMARK::Report::CSV);
+   ################################################################################
+*/
+
+#ifndef JIXIE_BENCHMARK_H
+#define JIXIE_BENCHMARK_H
+
+#include "Tools.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace JIXIE {
+namespace BENCHMARK {
+
+/**
+   \brief key=value options. Later values override earlier ones, config=<file> reads one key = value per line, # starts a comment.
+*/
+class Options {
+public:
+    Options() {}
+
+    Options(const int argc, const char* const argv[])
+    {
+        for (int i = 1; i < argc; i++)
+            parse(argv[i]);
+    }
+
+    void parse(std::string argument)
+    {
+        while (argument.compare(0, 1, "-") == 0)
+            argument.erase(0, 1);
+        size_t equal = argument.find('=');
+        if (equal == std::string::npos)
+            throw std::invalid_argument("expected key=value, got " + argument);
+        std::string key = trim(argument.substr(0, equal)), value = trim(argument.substr(equal + 1));
+        if (key == "config")
+            read(value);
+        else
+            values[key] = value;
+    }
+
+    void read(const std::string& file)
+    {
+        std::ifstream in(file);
+        if (!in)
+            throw std::invalid_argument("cannot open config file " + file);
+        std::string line;
+        while (std::getline(in, line)) {
+            line = trim(line.substr(0, line.find('#')));
+            if (!line.empty())
+                parse(line);
+        }
+    }
+
+    bool has(const std::string& key) const
+    {
+        return values.count(key) > 0;
+    }
+
+    std::string get(const std::string& key, const std::string& default_value) const
+    {
+        used.push_back(key);
+        auto it = values.find(key);
+        return it == values.end() ? default_value : it->second;
+    }
+
+    /**
+       Comma separated list
+    */
+    std::vector<std::string> getList(const std::string& key, const std::string& default_value) const
+    {
+        std::vector<std::string> list;
+        std::stringstream ss(get(key, default_value));
+        std::string item;
+        while (std::getline(ss, item, ','))
+            if (!trim(item).empty())
+                list.push_back(trim(item));
+        return list;
+    }
+
+    long long getInt(const std::string& key, const long long default_value) const
+    {
+        std::string v = get(key, "");
+        return v.empty() ? default_value : toInt(v);
+    }
+
+    double getDouble(const std::string& key, const double default_value) const
+    {
+        std::string v = get(key, "");
+        return v.empty() ? default_value : toDouble(v);
+    }
+
+    bool getBool(const std::string& key, const bool default_value) const
+    {
+        std::string v = get(key, default_value ? "true" : "false");
+        if (v == "true" || v == "1" || v == "yes")
+            return true;
+        if (v == "false" || v == "0" || v == "no")
+            return false;
+        throw std::invalid_argument("expected a boolean for " + key + ", got " + v);
+    }
+
+    /**
+       Keys that were given but never asked for, most likely typos
+    */
+    std::vector<std::string> unused() const
+    {
+        std::vector<std::string> keys;
+        for (const auto& kv : values)
+            if (std::find(used.begin(), used.end(), kv.first) == used.end())
+                keys.push_back(kv.first);
+        return keys;
+    }
+
+    static long long toInt(const std::string& s)
+    {
+        size_t end = 0;
+        long long v = 0;
+        try {
+            v = std::stoll(s, &end);
+        }
+        catch (const std::exception&) {
+            end = 0;
+        }
+        if (end == 0 || end != s.size())
+            throw std::invalid_argument("expected an integer, got " + s);
+        return v;
+    }
+
+    static double toDouble(const std::string& s)
+    {
+        size_t end = 0;
+        double v = 0;
+        try {
+            v = std::stod(s, &end);
+        }
+        catch (const std::exception&) {
+            end = 0;
+        }
+        if (end == 0 || end != s.size())
+            throw std::invalid_argument("expected a number, got " + s);
+        return v;
+    }
+
+private:
+    std::map<std::string, std::string> values;
+    mutable std::vector<std::string> used;
+
+    static std::string trim(const std::string& s)
+    {
+        size_t begin = s.find_first_not_of(" \t\r\n");
+        if (begin == std::string::npos)
+            return "";
+        return s.substr(begin, s.find_last_not_of(" \t\r\n") - begin + 1);
+    }
+};
+
+/**
+   \brief Time of warmup + repeat calls of f, only the last repeat are returned, in seconds.
+*/
+template <class F>
+inline std::vector<double> measure(const int warmup, const int repeat, F&& f)
+{
+    JIXIE::Timer timer;
+    std::vector<double> seconds;
+    for (int i = 0; i < warmup; i++)
+        f();
+    for (int i = 0; i < repeat; i++) {
+        timer.start();
+        f();
+        seconds.push_back(timer.click());
+    }
+    return seconds;
+}
+
+/**
+   \brief Statistics of repeated measurements after outlier rejection
+*/
+struct Summary {
+    size_t samples = 0;
+    size_t kept = 0;
+    double mean = 0;
+    double median = 0;
+    double min = 0;
+    double max = 0;
+    double stddev = 0;
+    double ci95 = 0; // half width of the 95% confidence interval of the mean
+};
+
+/**
+   Two sided 95% quantile of Student's t distribution
+*/
+inline double studentT95(const size_t degrees_of_freedom)
+{
+    static const double table[] = { 0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    if (degrees_of_freedom == 0)
+        return std::numeric_limits<double>::infinity();
+    if (degrees_of_freedom <= 30)
+        return table[degrees_of_freedom];
+    return 1.960 + 2.4 / degrees_of_freedom;
+}
+
+inline double median(std::vector<double> x)
+{
+    if (x.empty())
+        return 0;
+    size_t m = x.size() / 2;
+    std::nth_element(x.begin(), x.begin() + m, x.end());
+    double upper = x[m];
+    if (x.size() % 2)
+        return upper;
+    return (*std::max_element(x.begin(), x.begin() + m) + upper) / 2;
+}
+
+/**
+   q quantile of the samples by nearest rank, e.g. q = 0.99 for the 99th percentile
+*/
+inline double percentile(std::vector<double> x, const double q)
+{
+    if (x.empty())
+        return 0;
+    size_t rank = (size_t)std::ceil(q * x.size());
+    size_t k = std::min(x.size() - 1, rank ? rank - 1 : 0);
+    std::nth_element(x.begin(), x.begin() + k, x.end());
+    return x[k];
+}
+
+/**
+   \brief Summary of the samples without outliers.
+   A sample is an outlier if its modified z-score 0.6745 |x - median| / MAD exceeds outlier_threshold.
+   0 keeps every sample.
+*/
+inline Summary summarize(const std::vector<double>& samples, const double outlier_threshold)
+{
+    Summary s;
+    s.samples = samples.size();
+    if (samples.empty())
+        return s;
+    double m = median(samples);
+    std::vector<double> deviation;
+    for (double x : samples)
+        deviation.push_back(std::fabs(x - m));
+    double mad = median(deviation);
+    std::vector<double> kept;
+    for (double x : samples)
+        if (outlier_threshold <= 0 || mad == 0 || 0.6745 * std::fabs(x - m) / mad <= outlier_threshold)
+            kept.push_back(x);
+    s.kept = kept.size();
+    s.median = median(kept);
+    s.min = *std::min_element(kept.begin(), kept.end());
+    s.max = *std::max_element(kept.begin(), kept.end());
+    for (double x : kept)
+        s.mean += x;
+    s.mean /= kept.size();
+    if (kept.size() > 1) {
+        for (double x : kept)
+            s.stddev += (x - s.mean) * (x - s.mean);
+        s.stddev = std::sqrt(s.stddev / (kept.size() - 1));
+        s.ci95 = studentT95(kept.size() - 1) * s.stddev / std::sqrt((double)kept.size());
+    }
+    return s;
+}
+
+/**
+   \brief Pins the calling thread to one cpu and restores the cpus it was allowed to run on.
+   ThreadPool pins its workers over the cpus the constructing thread may use, so restore()
+   before constructing a pool and pin() after.
+*/
+class CpuPinning {
+public:
+    CpuPinning()
+    {
+#ifdef __linux__
+        CPU_ZERO(&original);
+        valid = sched_getaffinity(0, sizeof(original), &original) == 0;
+#endif
+    }
+
+    ~CpuPinning()
+    {
+        restore();
+    }
+
+    /**
+       Pin to the first allowed cpu, returns the cpu or -1
+    */
+    int pin()
+    {
+#ifdef __linux__
+        if (!valid)
+            return -1;
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &original)) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(c, &set);
+                return sched_setaffinity(0, sizeof(set), &set) == 0 ? c : -1;
+            }
+        }
+#endif
+        return -1;
+    }
+
+    void restore()
+    {
+#ifdef __linux__
+        if (valid)
+            sched_setaffinity(0, sizeof(original), &original);
+#endif
+    }
+
+private:
+#ifdef __linux__
+    cpu_set_t original;
+    bool valid = false;
+#endif
+};
+
+/**
+   \brief Rows of named fields written as an aligned text table, CSV or JSON.
+   Every row should set the same fields in the same order.
+*/
+class Report {
+public:
+    enum Format {
+        Text,
+        CSV,
+        JSON
+    };
+
+    class Row {
+    public:
+        Row& set(const std::string& key, const std::string& value)
+        {
+            fields.push_back({ key, { value, false } });
+            return *this;
+        }
+
+        Row& set(const std::string& key, const char* value)
+        {
+            return set(key, std::string(value));
+        }
+
+        template <class Number>
+        std::enable_if_t<std::is_arithmetic<Number>::value, Row&> set(const std::string& key, const Number value)
+        {
+            std::ostringstream ss;
+            ss << std::setprecision(std::is_integral<Number>::value ? 20 : 6) << value;
+            fields.push_back({ key, { ss.str(), true } });
+            return *this;
+        }
+
+        std::vector<std::pair<std::string, std::pair<std::string, bool> > > fields;
+    };
+
+    static Format format(const std::string& name)
+    {
+        if (name == "text")
+            return Text;
+        if (name == "csv")
+            return CSV;
+        if (name == "json")
+            return JSON;
+        throw std::invalid_argument("unknown format " + name + ", expected text, csv or json");
+    }
+
+    /**
+       Fields describing the whole run, only written in JSON
+    */
+    Row& header()
+    {
+        return run_info;
+    }
+
+    Row& add()
+    {
+        rows.emplace_back();
+        return rows.back();
+    }
+
+    void write(std::ostream& out, const Format format) const
+    {
+        if (format == JSON)
+            writeJSON(out);
+        else
+            writeTable(out, format == CSV ? "," : "  ", format == Text);
+    }
+
+private:
+    Row run_info;
+    std::vector<Row> rows;
+
+    void writeTable(std::ostream& out, const std::string& separator, const bool align) const
+    {
+        if (rows.empty())
+            return;
+        const auto& keys = rows.front().fields;
+        std::vector<size_t> width(keys.size());
+        for (size_t k = 0; k < keys.size(); k++) {
+            width[k] = keys[k].first.size();
+            for (const Row& r : rows)
+                if (align && k < r.fields.size())
+                    width[k] = std::max(width[k], r.fields[k].second.first.size());
+        }
+        for (size_t k = 0; k < keys.size(); k++)
+            out << (k ? separator : "") << std::setw(align ? width[k] : 0) << keys[k].first;
+        out << std::endl;
+        for (const Row& r : rows) {
+            for (size_t k = 0; k < r.fields.size(); k++)
+                out << (k ? separator : "") << std::setw(align ? width[k] : 0) << r.fields[k].second.first;
+            out << std::endl;
+        }
+    }
+
+    static std::string quote(const std::string& s)
+    {
+        std::string q = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\')
+                q += '\\';
+            q += c;
+        }
+        return q + "\"";
+    }
+
+    static void writeObject(std::ostream& out, const Row& r)
+    {
+        out << "{";
+        for (size_t k = 0; k < r.fields.size(); k++) {
+            const auto& value = r.fields[k].second;
+            bool finite = value.second && value.first.find_first_of("in") == std::string::npos;
+            out << (k ? ", " : "") << quote(r.fields[k].first) << ": " << (finite ? value.first : value.second ? "null" : quote(value.first));
+        }
+        out << "}";
+    }
+
+    void writeJSON(std::ostream& out) const
+    {
+        out << "{\n  \"run\": ";
+        writeObject(out, run_info);
+        out << ",\n  \"results\": [";
+        for (size_t i = 0; i < rows.size(); i++) {
+            out << (i ? ",\n    " : "\n    ");
+            writeObject(out, rows[i]);
+        }
+        out << "\n  ]\n}" << std::endl;
+    }
+};
+}
+}
+#endif
@@ -0,0 +1,90 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   Kernels of DispatchSVD.h for one instruction set variant. Compiled once per variant,
+   with JIXIE_DISPATCH_VARIANT set to SSE2, AVX2 or AVX512 and the matching -m flags.
+
+   The kernels are flattened so that every JIXIE and Eigen function they use is inlined.
+   No out of line copy of those inline functions is emitted, which could otherwise be
+   picked by the linker for code compiled for a different instruction set.
+   ################################################################################
+*/
+
+#include "DispatchSVD.h"
+#include "ImplicitQRSVD.h"
+#include "BatchSVD.h"
+
+#ifndef JIXIE_DISPATCH_VARIANT
+#error "Compile with -DJIXIE_DISPATCH_VARIANT=SSE2, AVX2 or AVX512"
+#endif
+
+#define JIXIE_DISPATCH_STRING_(x) #x
+#define JIXIE_DISPATCH_STRING(x) JIXIE_DISPATCH_STRING_(x)
+#define JIXIE_DISPATCH_CONCAT_(a, b) a##b
+#define JIXIE_DISPATCH_CONCAT(a, b) JIXIE_DISPATCH_CONCAT_(a, b)
+
+namespace JIXIE {
+namespace DISPATCH {
+namespace {
+
+template <class T>
+__attribute__((flatten)) void svdKernel(size_t n, const Eigen::Matrix<T, 3, 3>* A, Eigen::Matrix<T, 3, 3>* U, Eigen::Matrix<T, 3, 1>* sigma, Eigen::Matrix<T, 3, 3>* V)
+{
+    for (size_t i = 0; i < n; i++)
+        JIXIE::singularValueDecomposition(A[i], U[i], sigma[i], V[i]);
+}
+
+template <class T>
+__attribute__((flatten)) void polarKernel(size_t n, const Eigen::Matrix<T, 3, 3>* A, Eigen::Matrix<T, 3, 3>* R, Eigen::Matrix<T, 3, 3>* S_Sym)
+{
+    for (size_t i = 0; i < n; i++)
+        JIXIE::polarDecomposition(A[i], R[i], S_Sym[i]);
+}
+
+template <class T>
+__attribute__((flatten)) void batchSvdKernel(size_t n, const T* const A[9], T* const U[9], T* const sigma[3], T* const V[9], int* count)
+{
+    JIXIE::batchSingularValueDecomposition(n, A, U, sigma, V, count);
+}
+
+template <class T>
+KernelTable<T> table()
+{
+    return { svdKernel<T>, polarKernel<T>, batchSvdKernel<T>, SIMD::NativeWidth<T>::value };
+}
+}
+
+const Kernels& JIXIE_DISPATCH_CONCAT(kernels, JIXIE_DISPATCH_VARIANT)()
+{
+    static const Kernels kernels = { ISA::JIXIE_DISPATCH_VARIANT, JIXIE_DISPATCH_STRING(JIXIE_DISPATCH_VARIANT), table<float>(), table<double>() };
+    return kernels;
+}
+}
+}
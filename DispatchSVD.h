@@ -0,0 +1,184 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   This file selects, at run time, the best instruction set variant of the 3D SVD and
+   polar decomposition kernels. DispatchKernels.cpp is compiled once per variant with
+   the matching -m flags, see the Makefile, and the objects are linked in. Everything
+   else can be built for the baseline x86-64, so the binary runs on any host.
+
+   std::vector<Eigen::Matrix<T, 3, 3> > A(n), U(n), V(n), R(n), S(n);
+   std::vector<Eigen::Matrix<T, 3, 1> > sigma(n);
+   JIXIE::DISPATCH::singularValueDecomposition(n, A.data(), U.data(), sigma.data(), V.data());
+   JIXIE::DISPATCH::polarDecomposition(n, A.data(), R.data(), S.data());
+   JIXIE::DISPATCH::batchSingularValueDecomposition(n, A_streams, U_streams, sigma_streams, V_streams);
+   std::cout << JIXIE::DISPATCH::bestKernels().name; // e.g. AVX512
+   ################################################################################
+*/
+
+#ifndef JIXIE_DISPATCH_SVD_H
+#define JIXIE_DISPATCH_SVD_H
+
+#include <Eigen/Core>
+#include <cstddef>
+
+namespace JIXIE {
+namespace DISPATCH {
+
+/**
+   Instruction set variants, from oldest to newest
+*/
+enum class ISA {
+    SSE2,
+    AVX2, // with FMA
+    AVX512, // F, DQ and VL
+    Count
+};
+
+/**
+   Kernels over arrays of n matrices for one scalar type
+*/
+template <class T>
+struct KernelTable {
+    void (*singularValueDecomposition)(size_t n, const Eigen::Matrix<T, 3, 3>* A, Eigen::Matrix<T, 3, 3>* U, Eigen::Matrix<T, 3, 1>* sigma, Eigen::Matrix<T, 3, 3>* V);
+    void (*polarDecomposition)(size_t n, const Eigen::Matrix<T, 3, 3>* A, Eigen::Matrix<T, 3, 3>* R, Eigen::Matrix<T, 3, 3>* S_Sym);
+    void (*batchSingularValueDecomposition)(size_t n, const T* const A[9], T* const U[9], T* const sigma[3], T* const V[9], int* count);
+    int batch_lanes;
+};
+
+/**
+   All kernels of one instruction set variant
+*/
+struct Kernels {
+    ISA isa;
+    const char* name;
+    KernelTable<float> float_kernels;
+    KernelTable<double> double_kernels;
+
+    inline const KernelTable<float>& table(float) const { return float_kernels; }
+    inline const KernelTable<double>& table(double) const { return double_kernels; }
+};
+
+// Defined in the objects built from DispatchKernels.cpp
+const Kernels& kernelsSSE2();
+const Kernels& kernelsAVX2();
+const Kernels& kernelsAVX512();
+
+/**
+   Whether the cpu, and the operating system, support the instruction set
+*/
+inline bool supported(const ISA isa)
+{
+    __builtin_cpu_init();
+    switch (isa) {
+    case ISA::SSE2:
+        return __builtin_cpu_supports("sse2");
+    case ISA::AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case ISA::AVX512:
+        return supported(ISA::AVX2) && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl");
+    default:
+        return false;
+    }
+}
+
+/**
+   Kernels of the given variant, nullptr if this cpu cannot run them
+*/
+inline const Kernels* kernels(const ISA isa)
+{
+    if (!supported(isa))
+        return nullptr;
+    switch (isa) {
+    case ISA::SSE2:
+        return &kernelsSSE2();
+    case ISA::AVX2:
+        return &kernelsAVX2();
+    case ISA::AVX512:
+        return &kernelsAVX512();
+    default:
+        return nullptr;
+    }
+}
+
+/**
+   Newest variant this cpu can run, selected on the first call
+*/
+inline const Kernels& bestKernels()
+{
+    static const Kernels& best = [] () -> const Kernels& {
+        for (int i = (int)ISA::Count - 1; i > 0; i--)
+            if (const Kernels* k = kernels((ISA)i))
+                return *k;
+        return kernelsSSE2();
+    }();
+    return best;
+}
+
+/**
+   \brief 3X3 SVD of n matrices with the best variant, see JIXIE::singularValueDecomposition.
+*/
+template <class T>
+inline void singularValueDecomposition(const size_t n,
+    const Eigen::Matrix<T, 3, 3>* A,
+    Eigen::Matrix<T, 3, 3>* U,
+    Eigen::Matrix<T, 3, 1>* sigma,
+    Eigen::Matrix<T, 3, 3>* V)
+{
+    bestKernels().table(T()).singularValueDecomposition(n, A, U, sigma, V);
+}
+
+/**
+   \brief 3X3 polar decomposition of n matrices with the best variant, see JIXIE::polarDecomposition.
+*/
+template <class T>
+inline void polarDecomposition(const size_t n,
+    const Eigen::Matrix<T, 3, 3>* A,
+    Eigen::Matrix<T, 3, 3>* R,
+    Eigen::Matrix<T, 3, 3>* S_Sym)
+{
+    bestKernels().table(T()).polarDecomposition(n, A, R, S_Sym);
+}
+
+/**
+   \brief Batched 3X3 SVD of structure-of-arrays data with the best variant, see JIXIE::batchSingularValueDecomposition.
+*/
+template <class T>
+inline void batchSingularValueDecomposition(const size_t n,
+    const T* const A[9],
+    T* const U[9],
+    T* const sigma[3],
+    T* const V[9],
+    int* count = nullptr)
+{
+    bestKernels().table(T()).batchSingularValueDecomposition(n, A, U, sigma, V, count);
+}
+}
+}
+#endif
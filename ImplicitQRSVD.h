@@ -57,6 +57,11 @@
    // R will be the closest rotation to A
    // S will be symmetric
 
+   3D Polar with S packed:
+   JIXIE::SymmetricMatrix3<T> S6;
+   JIXIE::polarDecomposition(A, R, S6);
+   // Same R, S6(i,j) for the entries of S, S6.toDense() for the full matrix
+
    3D SVD:
    Eigen::Matrix<T, 3, 3> A;
    A<<1,2,3,4,5,6;
@@ -68,6 +73,27 @@
    // U and V will be rotations
    // S will be singular values sorted by decreasing magnitude. Only the last one may be negative.
 
+   3D SVD without U and/or V:
+   JIXIE::singularValueDecomposition<JIXIE::ComputeV>(A,U,S,V); // U is not touched
+   JIXIE::singularValueDecomposition<JIXIE::ComputeUV | JIXIE::Unsorted>(A,U,S,V); // no sort, only the smallest may be negative
+   JIXIE::singularValues(A,S);
+
+   3D SVD with another engine (see QuaternionJacobiSVD.h):
+   JIXIE::singularValueDecomposition<JIXIE::QuaternionJacobi>(A,U,S,V);
+
+   3D SVD with fast paths for diagonal, symmetric, upper bidiagonal and orthogonal A:
+   JIXIE::singularValueDecomposition<JIXIE::Structured>(A,U,S,V); // or structuredSingularValueDecomposition
+   // Same as 3D SVD, JIXIE::classifyStructure(A) tells which path A takes
+
+   Warm started 3D SVD:
+   JIXIE::singularValueDecomposition(A,U_prev,V_prev,U,S,V);
+   // Same as 3D SVD, U_prev and V_prev are rotations close to U and V (e.g. from the previous time step).
+
+   Warm started 3D Polar:
+   JIXIE::polarDecomposition(A,R_prev,R,S); // Givens sweeps from S = R_prev' A, R_prev may alias R
+   JIXIE::PolarRotationStore<T> store(n); // one rotation per element, kept from step to step
+   store.decompose(e, F, S); // R is store.rotation(e)
+
    ################################################################################
 */
 
@@ -78,9 +104,36 @@
 #define JIXIE_IMPLICIT_QR_SVD_H
 
 #include "Tools.h"
+#include "SVDStatistics.h"
 
 namespace JIXIE {
 
+namespace INTERNAL {
+/**
+   Rows of a givens rotation known at compile time
+*/
+template <int I, int K>
+struct GivensIndices {
+    static constexpr int rowi = I;
+    static constexpr int rowk = K;
+};
+
+/**
+   Rows of a givens rotation known at run time
+*/
+template <>
+struct GivensIndices<-1, -1> {
+    int rowi;
+    int rowk;
+
+    inline GivensIndices(int rowi_in, int rowk_in)
+        : rowi(rowi_in)
+        , rowk(rowk_in)
+    {
+    }
+};
+}
+
 /**
    Class for givens rotation.
    Row rotation G*A corresponds to something like
@@ -97,30 +150,58 @@ namespace JIXIE {
    s  c     b       ( 0 )
 
    Assume rowi<rowk.
+
+   GivensRotation<T> takes the rows at run time. GivensRotation<T, I, K> fixes them at compile time,
+   so the touched entries of the rotated matrix are known to the compiler and can stay in registers.
 */
-template <class T>
-class GivensRotation {
+template <class T, int I = -1, int K = -1>
+class GivensRotation : public INTERNAL::GivensIndices<I, K> {
+    using Indices = INTERNAL::GivensIndices<I, K>;
+
 public:
-    int rowi;
-    int rowk;
+    using Indices::rowi;
+    using Indices::rowk;
     T c;
     T s;
 
+    template <int I_ = I, std::enable_if_t<(I_ < 0), int> = 0>
     inline GivensRotation(int rowi_in, int rowk_in)
-        : rowi(rowi_in)
-         , rowk(rowk_in)
-         , c(1)
-         , s(0)
+        : Indices(rowi_in, rowk_in)
+        , c(1)
+        , s(0)
     {
     }
 
+    template <int I_ = I, std::enable_if_t<(I_ < 0), int> = 0>
     inline GivensRotation(T a, T b, int rowi_in, int rowk_in)
-        : rowi(rowi_in)
-         , rowk(rowk_in)
+        : Indices(rowi_in, rowk_in)
+    {
+        compute(a, b);
+    }
+
+    template <int I_ = I, std::enable_if_t<(I_ >= 0), int> = 0>
+    inline GivensRotation()
+        : c(1)
+        , s(0)
+    {
+    }
+
+    template <int I_ = I, std::enable_if_t<(I_ >= 0), int> = 0>
+    inline GivensRotation(T a, T b)
     {
         compute(a, b);
     }
 
+    /**
+       Same c and s as r, acting on rows I and K instead of r.rowi and r.rowk
+    */
+    template <int I_ = I, std::enable_if_t<(I_ >= 0), int> = 0>
+    inline explicit GivensRotation(const GivensRotation<T>& r)
+        : c(r.c)
+        , s(r.s)
+    {
+    }
+
     ~GivensRotation() {}
 
     inline void transposeInPlace()
@@ -220,7 +301,7 @@ public:
     /**
        Multiply givens must be for same row and column
     **/
-    inline void operator*=(const GivensRotation<T>& A)
+    inline void operator*=(const GivensRotation& A)
     {
         T new_c = c * A.c - s * A.s;
         T new_s = s * A.c + c * A.s;
@@ -231,14 +312,82 @@ public:
     /**
        Multiply givens must be for same row and column
     **/
-    inline GivensRotation<T> operator*(const GivensRotation<T>& A) const
+    inline GivensRotation operator*(const GivensRotation& A) const
     {
-        GivensRotation<T> r(*this);
+        GivensRotation r(*this);
         r *= A;
         return r;
     }
 };
 
+/**
+   Fixed capacity record of pairs of givens rotations, the first on rows I1 and K1, the second on rows I2 and K2,
+   applied later in the order they were recorded.
+   The rows are part of the type, so only c and s are stored and replaying costs the same as rotating right away.
+   The 3X3 SVD uses it to keep the updates of U and V out of the implicit QR loop.
+*/
+template <class T, int Capacity, int I1, int K1, int I2, int K2>
+class GivensSequence {
+public:
+    T c1[Capacity];
+    T s1[Capacity];
+    T c2[Capacity];
+    T s2[Capacity];
+    int size;
+
+    inline GivensSequence()
+        : size(0)
+    {
+    }
+
+    inline bool full() const
+    {
+        return size == Capacity;
+    }
+
+    inline void push(const GivensRotation<T, I1, K1>& r1, const GivensRotation<T, I2, K2>& r2)
+    {
+        c1[size] = r1.c;
+        s1[size] = r1.s;
+        c2[size] = r2.c;
+        s2[size] = r2.s;
+        size++;
+    }
+
+    /**
+       Same as calling columnRotation(A) of every recorded rotation in order. Empties the record.
+    */
+    template <class MatrixType>
+    inline void columnRotation(MatrixType& A)
+    {
+        GivensRotation<T, I1, K1> r1;
+        GivensRotation<T, I2, K2> r2;
+        for (int i = 0; i < size; i++) {
+            r1.c = c1[i];
+            r1.s = s1[i];
+            r2.c = c2[i];
+            r2.s = s2[i];
+            r1.columnRotation(A);
+            r2.columnRotation(A);
+        }
+        size = 0;
+    }
+};
+
+/**
+   Options of the 3X3 SVD selecting which of U and V are computed, similar to Eigen's ComputeFullU/ComputeFullV.
+   Rotations are not accumulated into a factor that is not requested, and that factor is left untouched.
+   Sigma is the same for every option up to round off. Round off may change the number of QR iterations and with it
+   the signs of the singular vectors, so U and V taken from two calls with different options need not match.
+*/
+enum SVDOptions {
+    ComputeSingularValuesOnly = 0,
+    ComputeU = 1,
+    ComputeV = 2,
+    ComputeUV = ComputeU | ComputeV,
+    Unsorted = 4 // singular values in no particular order, only the one of smallest magnitude may be negative
+};
+
 /**
    \brief zero chasing the 3X3 matrix to bidiagonal form
    original form of H:   x x 0
@@ -249,7 +398,7 @@ public:
    0 x x
    0 0 x
 */
-template <class T>
+template <int Options = ComputeUV, class T>
 inline void zeroChase(Eigen::Matrix<T, 3, 3>& H, Eigen::Matrix<T, 3, 3>& U, Eigen::Matrix<T, 3, 3>& V)
 {
 
@@ -259,7 +408,7 @@ inline void zeroChase(Eigen::Matrix<T, 3, 3>& H, Eigen::Matrix<T, 3, 3>& U, Eige
        0 x x
        0 0 x
     */
-    GivensRotation<T> r1(H(0, 0), H(1, 0), 0, 1);
+    GivensRotation<T, 0, 1> r1(H(0, 0), H(1, 0));
     /**
        Reduce H to of form
        x x 0
@@ -268,7 +417,7 @@ inline void zeroChase(Eigen::Matrix<T, 3, 3>& H, Eigen::Matrix<T, 3, 3>& U, Eige
        Can calculate r2 without multiplying by r1 since both entries are in first two
        rows thus no need to divide by sqrt(a^2+b^2)
     */
-    GivensRotation<T> r2(1, 2);
+    GivensRotation<T, 1, 2> r2;
     if (H(1, 0) != 0)
         r2.compute(H(0, 0) * H(0, 1) + H(1, 0) * H(1, 1), H(0, 0) * H(0, 2) + H(1, 0) * H(1, 2));
     else
@@ -276,9 +425,10 @@ inline void zeroChase(Eigen::Matrix<T, 3, 3>& H, Eigen::Matrix<T, 3, 3>& U, Eige
 
     r1.rowRotation(H);
 
-    /* GivensRotation<T> r2(H(0, 1), H(0, 2), 1, 2); */
+    /* GivensRotation<T, 1, 2> r2(H(0, 1), H(0, 2)); */
     r2.columnRotation(H);
-    r2.columnRotation(V);
+    if (Options & ComputeV)
+        r2.columnRotation(V);
 
     /**
        Reduce H to of form
@@ -286,14 +436,16 @@ inline void zeroChase(Eigen::Matrix<T, 3, 3>& H, Eigen::Matrix<T, 3, 3>& U, Eige
        0 x x
        0 0 x
     */
-    GivensRotation<T> r3(H(1, 1), H(2, 1), 1, 2);
+    GivensRotation<T, 1, 2> r3(H(1, 1), H(2, 1));
     r3.rowRotation(H);
 
     // Save this till end for better cache coherency
     // r1.rowRotation(u_transpose);
     // r3.rowRotation(u_transpose);
-    r1.columnRotation(U);
-    r3.columnRotation(U);
+    if (Options & ComputeU) {
+        r1.columnRotation(U);
+        r3.columnRotation(U);
+    }
 }
 
 /**
@@ -306,11 +458,13 @@ inline void zeroChase(Eigen::Matrix<T, 3, 3>& H, Eigen::Matrix<T, 3, 3>& U, Eige
    0 x x
    0 0 x
 */
-template <class T>
+template <int Options = ComputeUV, class T>
 inline void makeUpperBidiag(Eigen::Matrix<T, 3, 3>& H, Eigen::Matrix<T, 3, 3>& U, Eigen::Matrix<T, 3, 3>& V)
 {
-    U = Eigen::Matrix<T, 3, 3>::Identity();
-    V = Eigen::Matrix<T, 3, 3>::Identity();
+    if (Options & ComputeU)
+        U = Eigen::Matrix<T, 3, 3>::Identity();
+    if (Options & ComputeV)
+        V = Eigen::Matrix<T, 3, 3>::Identity();
 
     /**
        Reduce H to of form
@@ -319,12 +473,13 @@ inline void makeUpperBidiag(Eigen::Matrix<T, 3, 3>& H, Eigen::Matrix<T, 3, 3>& U
        0 x x
     */
 
-    GivensRotation<T> r(H(1, 0), H(2, 0), 1, 2);
+    GivensRotation<T, 1, 2> r(H(1, 0), H(2, 0));
     r.rowRotation(H);
     // r.rowRotation(u_transpose);
-    r.columnRotation(U);
+    if (Options & ComputeU)
+        r.columnRotation(U);
     // zeroChase(H, u_transpose, V);
-    zeroChase(H, U, V);
+    zeroChase<Options>(H, U, V);
 }
 
 /**
@@ -350,7 +505,7 @@ inline void makeLambdaShape(Eigen::Matrix<T, 3, 3>& H, Eigen::Matrix<T, 3, 3>& U
        *                    x x x
        */
 
-    GivensRotation<T> r1(H(0, 1), H(0, 2), 1, 2);
+    GivensRotation<T, 1, 2> r1(H(0, 1), H(0, 2));
     r1.columnRotation(H);
     r1.columnRotation(V);
 
@@ -372,7 +527,7 @@ inline void makeLambdaShape(Eigen::Matrix<T, 3, 3>& H, Eigen::Matrix<T, 3, 3>& U
        *                    x 0 x
        */
 
-    GivensRotation<T> r2(H(2, 0), H(2, 1), 0, 1);
+    GivensRotation<T, 0, 1> r2(H(2, 0), H(2, 1));
     r2.columnRotation(H);
     r2.columnRotation(V);
 
@@ -564,10 +719,71 @@ T wilkinsonShift(const T a1, const T b1, const T a2)
     return mu;
 }
 
+/**
+   \brief One implicit shift QR step of the 3X3 SVD, i.e. a column rotation by the shift followed by zeroChase,
+   on the upper bidiagonal matrix
+   alpha_1 beta_1  0
+   0       alpha_2 beta_2
+   0       0       alpha_3
+   held in scalars. The bulge lives in a local, entries that are zero in exact arithmetic are never formed.
+   The rotations of U and V are recorded, not applied. Both records must not be full.
+*/
+template <int Options = ComputeUV, class T, int Capacity>
+inline void bidiagonalQRStep(T& alpha_1, T& beta_1, T& alpha_2, T& beta_2, T& alpha_3, const T mu,
+    GivensSequence<T, Capacity, 0, 1, 1, 2>& u_rotations, GivensSequence<T, Capacity, 0, 1, 1, 2>& v_rotations)
+{
+    /**
+       Column rotation by the shift gives
+       h00 h01 0
+       h10 h11 beta_2
+       0   0   alpha_3
+    */
+    GivensRotation<T, 0, 1> r(alpha_1 * alpha_1 - mu, alpha_1 * beta_1);
+    T h00 = r.c * alpha_1 - r.s * beta_1;
+    T h01 = r.s * alpha_1 + r.c * beta_1;
+    T h10 = -r.s * alpha_2;
+    T h11 = r.c * alpha_2;
+
+    /**
+       Same rotations as zeroChase, r2 is computed without multiplying by r1
+    */
+    GivensRotation<T, 0, 1> r1(h00, h10);
+    GivensRotation<T, 1, 2> r2;
+    if (h10 != 0)
+        r2.compute(h00 * h01 + h10 * h11, h10 * beta_2);
+    else
+        r2.compute(h01, 0);
+
+    // Row rotation r1 leaves the bulge in (0,2)
+    alpha_1 = r1.c * h00 - r1.s * h10;
+    T g01 = r1.c * h01 - r1.s * h11;
+    T bulge = -r1.s * beta_2;
+    T g11 = r1.s * h01 + r1.c * h11;
+    T g12 = r1.c * beta_2;
+
+    // Column rotation r2 moves the bulge to (2,1)
+    beta_1 = r2.c * g01 - r2.s * bulge;
+    T k11 = r2.c * g11 - r2.s * g12;
+    T k12 = r2.s * g11 + r2.c * g12;
+    bulge = -r2.s * alpha_3;
+    T k22 = r2.c * alpha_3;
+
+    // Row rotation r3 removes it
+    GivensRotation<T, 1, 2> r3(k11, bulge);
+    alpha_2 = r3.c * k11 - r3.s * bulge;
+    beta_2 = r3.c * k12 - r3.s * k22;
+    alpha_3 = r3.s * k12 + r3.c * k22;
+
+    if (Options & ComputeU)
+        u_rotations.push(r1, r3);
+    if (Options & ComputeV)
+        v_rotations.push(r, r2);
+}
+
 /**
    \brief Helper function of 3X3 SVD for processing 2X2 SVD
 */
-template <int t, class T>
+template <int t, int Options = ComputeUV, class T>
 inline void process(Eigen::Matrix<T, 3, 3>& B, Eigen::Matrix<T, 3, 3>& U, Eigen::Matrix<T, 3, 1>& sigma, Eigen::Matrix<T, 3, 3>& V)
 {
     int other = (t == 1) ? 0 : 2;
@@ -575,117 +791,159 @@ inline void process(Eigen::Matrix<T, 3, 3>& B, Eigen::Matrix<T, 3, 3>& U, Eigen:
     GivensRotation<T> v(0, 1);
     sigma(other) = B(other, other);
     singularValueDecomposition(B.template block<2, 2>(t, t), u, sigma.template block<2, 1>(t, 0), v);
-    u.rowi += t;
-    u.rowk += t;
-    v.rowi += t;
-    v.rowk += t;
-    u.columnRotation(U);
-    v.columnRotation(V);
+    if (Options & ComputeU)
+        GivensRotation<T, t, t + 1>(u).columnRotation(U);
+    if (Options & ComputeV)
+        GivensRotation<T, t, t + 1>(v).columnRotation(V);
 }
 
 /**
    \brief Helper function of 3X3 SVD for flipping signs due to flipping signs of sigma
 */
-template <class T>
+template <int Options = ComputeUV, class T>
 inline void flipSign(int i, Eigen::Matrix<T, 3, 3>& U, Eigen::Matrix<T, 3, 1>& sigma)
 {
     sigma(i) = -sigma(i);
-    U.col(i) = -U.col(i);
+    if (Options & ComputeU)
+        U.col(i) = -U.col(i);
+}
+
+/**
+   \brief Helper function of 3X3 SVD with the Unsorted option: moves negative signs onto the
+   singular value of smallest magnitude, two at a time, instead of sorting
+*/
+template <int Options = ComputeUV, class T>
+inline void signToSmallest(Eigen::Matrix<T, 3, 3>& U, Eigen::Matrix<T, 3, 1>& sigma)
+{
+    using std::fabs;
+    int smallest = fabs(sigma(0)) < fabs(sigma(1)) ? 0 : 1;
+    if (fabs(sigma(2)) < fabs(sigma(smallest)))
+        smallest = 2;
+    for (int i = 0; i < 3; i++)
+        if (i != smallest && sigma(i) < 0) {
+            flipSign<Options>(i, U, sigma);
+            flipSign<Options>(smallest, U, sigma);
+        }
 }
 
 /**
    \brief Helper function of 3X3 SVD for sorting singular values
 */
-template <int t, class T>
+template <int t, int Options = ComputeUV, class T>
 std::enable_if_t<t == 0> sort(Eigen::Matrix<T, 3, 3>& U, Eigen::Matrix<T, 3, 1>& sigma, Eigen::Matrix<T, 3, 3>& V)
 {
     using std::fabs;
+    if (Options & Unsorted) {
+        signToSmallest<Options>(U, sigma);
+        return;
+    }
 
     // Case: sigma(0) > |sigma(1)| >= |sigma(2)|
     if (fabs(sigma(1)) >= fabs(sigma(2))) {
+        STATISTICS::recordSortCase(STATISTICS::Sort0InOrder);
         if (sigma(1) < 0) {
-            flipSign(1, U, sigma);
-            flipSign(2, U, sigma);
+            flipSign<Options>(1, U, sigma);
+            flipSign<Options>(2, U, sigma);
         }
         return;
     }
 
     //fix sign of sigma for both cases
     if (sigma(2) < 0) {
-        flipSign(1, U, sigma);
-        flipSign(2, U, sigma);
+        flipSign<Options>(1, U, sigma);
+        flipSign<Options>(2, U, sigma);
     }
 
     //swap sigma(1) and sigma(2) for both cases
     std::swap(sigma(1), sigma(2));
-    U.col(1).swap(U.col(2));
-    V.col(1).swap(V.col(2));
+    if (Options & ComputeU)
+        U.col(1).swap(U.col(2));
+    if (Options & ComputeV)
+        V.col(1).swap(V.col(2));
 
     // Case: |sigma(2)| >= sigma(0) > |simga(1)|
     if (sigma(1) > sigma(0)) {
+        STATISTICS::recordSortCase(STATISTICS::Sort0MoveLastToFront);
         std::swap(sigma(0), sigma(1));
-        U.col(0).swap(U.col(1));
-        V.col(0).swap(V.col(1));
+        if (Options & ComputeU)
+            U.col(0).swap(U.col(1));
+        if (Options & ComputeV)
+            V.col(0).swap(V.col(1));
     }
 
     // Case: sigma(0) >= |sigma(2)| > |simga(1)|
     else {
-        U.col(2) = -U.col(2);
-        V.col(2) = -V.col(2);
+        STATISTICS::recordSortCase(STATISTICS::Sort0SwapLastTwo);
+        if (Options & ComputeU)
+            U.col(2) = -U.col(2);
+        if (Options & ComputeV)
+            V.col(2) = -V.col(2);
     }
 }
 
 /**
    \brief Helper function of 3X3 SVD for sorting singular values
 */
-template <int t, class T>
+template <int t, int Options = ComputeUV, class T>
 std::enable_if_t<t == 1> sort(Eigen::Matrix<T, 3, 3>& U, Eigen::Matrix<T, 3, 1>& sigma, Eigen::Matrix<T, 3, 3>& V)
 {
     using std::fabs;
+    if (Options & Unsorted) {
+        signToSmallest<Options>(U, sigma);
+        return;
+    }
 
     // Case: |sigma(0)| >= sigma(1) > |sigma(2)|
     if (fabs(sigma(0)) >= sigma(1)) {
+        STATISTICS::recordSortCase(STATISTICS::Sort1InOrder);
         if (sigma(0) < 0) {
-            flipSign(0, U, sigma);
-            flipSign(2, U, sigma);
+            flipSign<Options>(0, U, sigma);
+            flipSign<Options>(2, U, sigma);
         }
         return;
     }
 
     //swap sigma(0) and sigma(1) for both cases
     std::swap(sigma(0), sigma(1));
-    U.col(0).swap(U.col(1));
-    V.col(0).swap(V.col(1));
+    if (Options & ComputeU)
+        U.col(0).swap(U.col(1));
+    if (Options & ComputeV)
+        V.col(0).swap(V.col(1));
 
     // Case: sigma(1) > |sigma(2)| >= |sigma(0)|
     if (fabs(sigma(1)) < fabs(sigma(2))) {
+        STATISTICS::recordSortCase(STATISTICS::Sort1MoveFirstToBack);
         std::swap(sigma(1), sigma(2));
-        U.col(1).swap(U.col(2));
-        V.col(1).swap(V.col(2));
+        if (Options & ComputeU)
+            U.col(1).swap(U.col(2));
+        if (Options & ComputeV)
+            V.col(1).swap(V.col(2));
     }
 
     // Case: sigma(1) >= |sigma(0)| > |sigma(2)|
     else {
-        U.col(1) = -U.col(1);
-        V.col(1) = -V.col(1);
+        STATISTICS::recordSortCase(STATISTICS::Sort1SwapFirstTwo);
+        if (Options & ComputeU)
+            U.col(1) = -U.col(1);
+        if (Options & ComputeV)
+            V.col(1) = -V.col(1);
     }
 
     // fix sign for both cases
     if (sigma(1) < 0) {
-        flipSign(1, U, sigma);
-        flipSign(2, U, sigma);
+        flipSign<Options>(1, U, sigma);
+        flipSign<Options>(2, U, sigma);
     }
 }
 
 /**
-   \brief 3X3 SVD (singular value decomposition) A=USV'
-   \param[in] A Input matrix.
-   \param[out] U is a rotation matrix.
-   \param[out] sigma Diagonal matrix, sorted with decreasing magnitude. The third one can be negative.
-   \param[out] V is a rotation matrix.
+   \brief The 3X3 SVD of an upper bidiagonal B, the part of singularValueDecomposition after makeUpperBidiag.
+   \param[in] B Upper bidiagonal. Overwritten.
+   \param[in,out] U, V The rotations that took A to B, A = U B V'. Afterwards A = U sigma V'.
+   \return Number of QR iterations.
 */
-template <class T>
-inline int singularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
+template <int Options = ComputeUV, class T>
+inline int bidiagonalSingularValueDecomposition(Eigen::Matrix<T, 3, 3>& B,
     Eigen::Matrix<T, 3, 3>& U,
     Eigen::Matrix<T, 3, 1>& sigma,
     Eigen::Matrix<T, 3, 3>& V,
@@ -694,24 +952,18 @@ inline int singularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
     using std::fabs;
     using std::sqrt;
     using std::max;
-    Eigen::Matrix<T, 3, 3> B = A;
-    U = Eigen::Matrix<T, 3, 3>::Identity();
-    V = Eigen::Matrix<T, 3, 3>::Identity();
-
-    makeUpperBidiag(B, U, V);
-
     int count = 0;
     T mu = (T)0;
-    GivensRotation<T> r(0, 1);
+    // Rotations of 8 QR sweeps, U and V are only touched inside the loop if there are more
+    GivensSequence<T, 8, 0, 1, 1, 2> u_rotations, v_rotations;
 
     T alpha_1 = B(0, 0);
     T beta_1 = B(0, 1);
     T alpha_2 = B(1, 1);
     T alpha_3 = B(2, 2);
     T beta_2 = B(1, 2);
-    T gamma_1 = alpha_1 * beta_1;
     T gamma_2 = alpha_2 * beta_2;
-    tol *= max((T)0.5 * sqrt(alpha_1 * alpha_1 + alpha_2 * alpha_2 + alpha_3 * alpha_3 + beta_1 * beta_1 + beta_2 * beta_2), (T)1);
+    tol *= max((T)0.5 * sqrt(alpha_1 * alpha_1 + alpha_2 * alpha_2 + alpha_3 * alpha_3 + beta_1 * beta_1 + beta_2 * beta_2), std::numeric_limits<T>::min());
 
     /**
        Do implicit shift QR until A^T A is block diagonal
@@ -721,22 +973,22 @@ inline int singularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
         && fabs(alpha_1) > tol && fabs(alpha_2) > tol
         && fabs(alpha_3) > tol) {
         mu = wilkinsonShift(alpha_2 * alpha_2 + beta_1 * beta_1, gamma_2, alpha_3 * alpha_3 + beta_2 * beta_2);
-
-        r.compute(alpha_1 * alpha_1 - mu, gamma_1);
-        r.columnRotation(B);
-
-        r.columnRotation(V);
-        zeroChase(B, U, V);
-
-        alpha_1 = B(0, 0);
-        beta_1 = B(0, 1);
-        alpha_2 = B(1, 1);
-        alpha_3 = B(2, 2);
-        beta_2 = B(1, 2);
-        gamma_1 = alpha_1 * beta_1;
+        if (u_rotations.full())
+            u_rotations.columnRotation(U);
+        if (v_rotations.full())
+            v_rotations.columnRotation(V);
+        bidiagonalQRStep<Options>(alpha_1, beta_1, alpha_2, beta_2, alpha_3, mu, u_rotations, v_rotations);
         gamma_2 = alpha_2 * beta_2;
         count++;
     }
+    STATISTICS::recordIterations(count);
+    if (Options & ComputeU)
+        u_rotations.columnRotation(U);
+    if (Options & ComputeV)
+        v_rotations.columnRotation(V);
+    B << alpha_1, beta_1, 0,
+        0, alpha_2, beta_2,
+        0, 0, alpha_3;
     /**
        Handle the cases of one of the alphas and betas being 0
        Sorted by ease of handling and then frequency
@@ -748,8 +1000,9 @@ inline int singularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
        0 0 x
     */
     if (fabs(beta_2) <= tol) {
-        process<0>(B, U, sigma, V);
-        sort<0>(U, sigma, V);
+        STATISTICS::recordBranch(STATISTICS::SmallBeta2);
+        process<0, Options>(B, U, sigma, V);
+        sort<0, Options>(U, sigma, V);
     }
     /**
        If B is of form
@@ -758,8 +1011,9 @@ inline int singularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
        0 0 x
     */
     else if (fabs(beta_1) <= tol) {
-        process<1>(B, U, sigma, V);
-        sort<1>(U, sigma, V);
+        STATISTICS::recordBranch(STATISTICS::SmallBeta1);
+        process<1, Options>(B, U, sigma, V);
+        sort<1, Options>(U, sigma, V);
     }
     /**
        If B is of form
@@ -768,19 +1022,21 @@ inline int singularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
        0 0 x
     */
     else if (fabs(alpha_2) <= tol) {
+        STATISTICS::recordBranch(STATISTICS::SmallAlpha2);
         /**
            Reduce B to
            x x 0
            0 0 0
            0 0 x
         */
-        GivensRotation<T> r1(1, 2);
+        GivensRotation<T, 1, 2> r1;
         r1.computeUnconventional(B(1, 2), B(2, 2));
         r1.rowRotation(B);
-        r1.columnRotation(U);
+        if (Options & ComputeU)
+            r1.columnRotation(U);
 
-        process<0>(B, U, sigma, V);
-        sort<0>(U, sigma, V);
+        process<0, Options>(B, U, sigma, V);
+        sort<0, Options>(U, sigma, V);
     }
     /**
        If B is of form
@@ -789,29 +1045,32 @@ inline int singularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
        0 0 0
     */
     else if (fabs(alpha_3) <= tol) {
+        STATISTICS::recordBranch(STATISTICS::SmallAlpha3);
         /**
            Reduce B to
            x x +
            0 x 0
            0 0 0
         */
-        GivensRotation<T> r1(1, 2);
+        GivensRotation<T, 1, 2> r1;
         r1.compute(B(1, 1), B(1, 2));
         r1.columnRotation(B);
-        r1.columnRotation(V);
+        if (Options & ComputeV)
+            r1.columnRotation(V);
         /**
            Reduce B to
            x x 0
            + x 0
            0 0 0
         */
-        GivensRotation<T> r2(0, 2);
+        GivensRotation<T, 0, 2> r2;
         r2.compute(B(0, 0), B(0, 2));
         r2.columnRotation(B);
-        r2.columnRotation(V);
+        if (Options & ComputeV)
+            r2.columnRotation(V);
 
-        process<0>(B, U, sigma, V);
-        sort<0>(U, sigma, V);
+        process<0, Options>(B, U, sigma, V);
+        sort<0, Options>(U, sigma, V);
     }
     /**
        If B is of form
@@ -820,16 +1079,18 @@ inline int singularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
        0 0 x
     */
     else if (fabs(alpha_1) <= tol) {
+        STATISTICS::recordBranch(STATISTICS::SmallAlpha1);
         /**
            Reduce B to
            0 0 +
            0 x x
            0 0 x
         */
-        GivensRotation<T> r1(0, 1);
+        GivensRotation<T, 0, 1> r1;
         r1.computeUnconventional(B(0, 1), B(1, 1));
         r1.rowRotation(B);
-        r1.columnRotation(U);
+        if (Options & ComputeU)
+            r1.columnRotation(U);
 
         /**
            Reduce B to
@@ -837,18 +1098,439 @@ inline int singularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
            0 x x
            0 + x
         */
-        GivensRotation<T> r2(0, 2);
+        GivensRotation<T, 0, 2> r2;
         r2.computeUnconventional(B(0, 2), B(2, 2));
         r2.rowRotation(B);
-        r2.columnRotation(U);
+        if (Options & ComputeU)
+            r2.columnRotation(U);
+
+        process<1, Options>(B, U, sigma, V);
+        sort<1, Options>(U, sigma, V);
+    }
+
+    return count;
+}
+
+/**
+   \brief Range of the largest entry of |A| for which the Givens rotations of the 3X3 SVD, whose
+   arguments are products of entries and which square them, neither underflow nor overflow.
+   Matrices outside are scaled into it by a power of 2.
+*/
+template <class T>
+struct SafeScale {
+    static constexpr T lower = MATH_TOOLS::powerOfTwo<T>(std::numeric_limits<T>::min_exponent / 8);
+    static constexpr T upper = MATH_TOOLS::powerOfTwo<T>(std::numeric_limits<T>::max_exponent / 8);
+
+    /**
+       \brief Power of 2 that brings the largest entry of |A| to [0.5, 1) if it is outside the range,
+       1 if it is inside the range and for 0, inf and nan
+    */
+    static inline T factor(const Eigen::Matrix<T, 3, 3>& A)
+    {
+        T m = A.cwiseAbs().maxCoeff();
+        if (m >= lower && m <= upper)
+            return 1;
+        int e = 0;
+        if (m > 0 && m <= std::numeric_limits<T>::max())
+            std::frexp(m, &e);
+        return std::ldexp((T)1, -e);
+    }
+};
+
+template <class T>
+constexpr T SafeScale<T>::lower;
+template <class T>
+constexpr T SafeScale<T>::upper;
+
+/**
+   \brief 3X3 SVD (singular value decomposition) A=USV'
+   \param[in] A Input matrix.
+   \param[out] U is a rotation matrix.
+   \param[out] sigma Diagonal matrix, sorted with decreasing magnitude. The third one can be negative.
+   \param[out] V is a rotation matrix.
+   \param[in] tol Relative to |A|, entries of the bidiagonal matrix below it count as 0.
+   \tparam Options Which of U and V to compute, see SVDOptions. A factor that is not computed is left untouched.
+   A whose largest entry is outside SafeScale is scaled by a power of 2 first, which is exact.
+*/
+template <int Options = ComputeUV, class T>
+inline int singularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
+    Eigen::Matrix<T, 3, 3>& U,
+    Eigen::Matrix<T, 3, 1>& sigma,
+    Eigen::Matrix<T, 3, 3>& V,
+    T tol = 128 * std::numeric_limits<T>::epsilon())
+{
+    T scale = SafeScale<T>::factor(A);
+    if (scale != 1) {
+        int count = singularValueDecomposition<Options>((scale * A).eval(), U, sigma, V, tol);
+        sigma /= scale;
+        return count;
+    }
+
+    Eigen::Matrix<T, 3, 3> B = A;
+
+    makeUpperBidiag<Options>(B, U, V);
+
+    return bidiagonalSingularValueDecomposition<Options>(B, U, sigma, V, tol);
+}
+
+/**
+   \brief Singular values of a 3X3 matrix, same as singularValueDecomposition without computing U and V.
+   \param[in] A Input matrix.
+   \param[out] sigma Diagonal matrix, sorted with decreasing magnitude. The third one can be negative.
+*/
+template <class T>
+inline int singularValues(const Eigen::Matrix<T, 3, 3>& A,
+    Eigen::Matrix<T, 3, 1>& sigma,
+    T tol = 128 * std::numeric_limits<T>::epsilon())
+{
+    Eigen::Matrix<T, 3, 3> U, V;
+    return singularValueDecomposition<ComputeSingularValuesOnly>(A, U, sigma, V, tol);
+}
+
+/**
+   Engine policy for singularValueDecomposition<Engine>: the implicit shifted QR SVD above.
+   Other engines (e.g. QuaternionJacobi in QuaternionJacobiSVD.h) provide the same static run function.
+*/
+struct ImplicitQR {
+    template <int Options, class T>
+    static inline int run(const Eigen::Matrix<T, 3, 3>& A,
+        Eigen::Matrix<T, 3, 3>& U,
+        Eigen::Matrix<T, 3, 1>& sigma,
+        Eigen::Matrix<T, 3, 3>& V)
+    {
+        return singularValueDecomposition<Options>(A, U, sigma, V);
+    }
+};
+
+/**
+   \brief 3X3 SVD A=USV' computed by the given engine policy, with the same conventions as singularValueDecomposition.
+   \tparam Engine ImplicitQR, QuaternionJacobi, ...
+   \tparam Options Which of U and V to compute, see SVDOptions.
+   \return Engine specific iteration count.
+*/
+template <class Engine, int Options = ComputeUV, class T>
+inline int singularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
+    Eigen::Matrix<T, 3, 3>& U,
+    Eigen::Matrix<T, 3, 1>& sigma,
+    Eigen::Matrix<T, 3, 3>& V)
+{
+    return Engine::template run<Options>(A, U, sigma, V);
+}
+
+/**
+   \brief Helper function of the warm started 3X3 SVD.
+   Two sided Jacobi step that zeros B(i,k) and B(k,i) with the 2x2 SVD of rows and columns i and k.
+*/
+template <int i, int k, class T>
+inline void jacobiStep(Eigen::Matrix<T, 3, 3>& B, Eigen::Matrix<T, 3, 3>& U, Eigen::Matrix<T, 3, 3>& V)
+{
+    Eigen::Matrix<T, 2, 2> block;
+    block << B(i, i), B(i, k), B(k, i), B(k, k);
+    Eigen::Matrix<T, 2, 1> sigma;
+    GivensRotation<T> u(0, 1);
+    GivensRotation<T> v(0, 1);
+    singularValueDecomposition(block, u, sigma, v);
+    GivensRotation<T, i, k> u_ik(u);
+    GivensRotation<T, i, k> v_ik(v);
+
+    // B = u' B v
+    u_ik.rowRotation(B);
+    v_ik.columnRotation(B);
+    B(i, i) = sigma(0);
+    B(k, k) = sigma(1);
+    B(i, k) = 0;
+    B(k, i) = 0;
+
+    u_ik.columnRotation(U);
+    v_ik.columnRotation(V);
+}
+
+/**
+   \brief Helper function of the warm started 3X3 SVD for sorting the singular values of a diagonal matrix.
+   U and V must be rotations. Afterwards sigma is sorted with decreasing magnitude, only the last one can be
+   negative, and U and V are still rotations.
+*/
+template <class T>
+inline void sortDiagonal(Eigen::Matrix<T, 3, 3>& U, Eigen::Matrix<T, 3, 1>& sigma, Eigen::Matrix<T, 3, 3>& V)
+{
+    // Every flip changes the sign of det(U)
+    bool negative = false;
+    for (int i = 0; i < 3; i++) {
+        if (sigma(i) < 0) {
+            flipSign(i, U, sigma);
+            negative = !negative;
+        }
+    }
+
+    // Swapping two columns of both U and V and negating one of them keeps both determinants
+    auto swap = [&](int i, int k) {
+        std::swap(sigma(i), sigma(k));
+        U.col(i).swap(U.col(k));
+        V.col(i).swap(V.col(k));
+        U.col(k) = -U.col(k);
+        V.col(k) = -V.col(k);
+    };
+    if (sigma(0) < sigma(1))
+        swap(0, 1);
+    if (sigma(1) < sigma(2))
+        swap(1, 2);
+    if (sigma(0) < sigma(1))
+        swap(0, 1);
+
+    if (negative)
+        flipSign(2, U, sigma);
+}
+
+/**
+   \brief Warm started 3X3 SVD (singular value decomposition) A=USV'
+   \param[in] A Input matrix.
+   \param[in] U_hint A rotation close to U, typically U of the previous time step.
+   \param[in] V_hint A rotation close to V, typically V of the previous time step.
+   \param[out] U is a rotation matrix. May be the same object as U_hint.
+   \param[out] sigma Diagonal matrix, sorted with decreasing magnitude. The third one can be negative.
+   \param[out] V is a rotation matrix. May be the same object as V_hint.
+   \return Number of Jacobi sweeps, plus the QR iterations if the hint was too far off.
+
+   A is pre-rotated into B = U_hint' A V_hint. Reducing B to bidiagonal form would throw the
+   hint away (the Givens rotations of makeUpperBidiag are arbitrary when B is close to diagonal),
+   so B is diagonalized with two sided Jacobi sweeps instead. They converge quadratically
+   when B is close to diagonal. If max_sweeps is not enough the implicit QR version finishes the job.
+   A whose largest entry is outside SafeScale is scaled by a power of 2 first, like in singularValueDecomposition.
+*/
+template <class T>
+inline int singularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
+    const Eigen::Matrix<T, 3, 3>& U_hint,
+    const Eigen::Matrix<T, 3, 3>& V_hint,
+    Eigen::Matrix<T, 3, 3>& U,
+    Eigen::Matrix<T, 3, 1>& sigma,
+    Eigen::Matrix<T, 3, 3>& V,
+    T tol = 128 * std::numeric_limits<T>::epsilon(),
+    const int max_sweeps = 3)
+{
+    using std::fabs;
+    using std::max;
+    T scale = SafeScale<T>::factor(A);
+    if (scale != 1) {
+        int sweeps = singularValueDecomposition((scale * A).eval(), U_hint, V_hint, U, sigma, V, tol, max_sweeps);
+        sigma /= scale;
+        return sweeps;
+    }
+
+    Eigen::Matrix<T, 3, 3> B;
+    B.noalias() = U_hint.transpose() * A * V_hint;
+    U = U_hint;
+    V = V_hint;
+    tol *= max((T)0.5 * B.norm(), std::numeric_limits<T>::min());
+
+    auto offDiagonal = [&]() {
+        return max(max(max(fabs(B(0, 1)), fabs(B(1, 0))), max(fabs(B(0, 2)), fabs(B(2, 0)))), max(fabs(B(1, 2)), fabs(B(2, 1))));
+    };
+    // Pairs that are already diagonal are skipped
+    int sweeps = 0;
+    while (offDiagonal() > tol && sweeps < max_sweeps) {
+        if (max(fabs(B(0, 1)), fabs(B(1, 0))) > tol)
+            jacobiStep<0, 1>(B, U, V);
+        if (max(fabs(B(0, 2)), fabs(B(2, 0))) > tol)
+            jacobiStep<0, 2>(B, U, V);
+        if (max(fabs(B(1, 2)), fabs(B(2, 1))) > tol)
+            jacobiStep<1, 2>(B, U, V);
+        sweeps++;
+    }
+
+    if (offDiagonal() > tol) {
+        Eigen::Matrix<T, 3, 3> UB, VB;
+        sweeps += singularValueDecomposition(B, UB, sigma, VB);
+        U = U * UB;
+        V = V * VB;
+        return sweeps;
+    }
+
+    sigma = B.diagonal();
+    sortDiagonal(U, sigma, V);
+    return sweeps;
+}
+
+/**
+   \brief Cheap test for the structures the Structured engine has fast paths for, see STATISTICS::Structure.
+   \param[in] A Input matrix.
+   \param[in] tol Largest entry of |A' A - I| that still counts as orthogonal.
+
+   The exact tests combine their compares with & so they compile to a few compares and one branch each.
+   Only matrices that are none of diagonal, symmetric or bidiagonal pay for A' A, and only if their first
+   column has unit length.
+*/
+template <class T>
+inline STATISTICS::Structure classifyStructure(const Eigen::Matrix<T, 3, 3>& A,
+    const T tol = 8 * std::numeric_limits<T>::epsilon())
+{
+    using std::fabs;
+    bool lower_zero = (A(1, 0) == 0) & (A(2, 0) == 0) & (A(2, 1) == 0);
+    bool bidiagonal = lower_zero & (A(0, 2) == 0);
+    if (bidiagonal & (A(0, 1) == 0) & (A(1, 2) == 0))
+        return STATISTICS::DiagonalStructure;
+    if ((A(0, 1) == A(1, 0)) & (A(0, 2) == A(2, 0)) & (A(1, 2) == A(2, 1)))
+        return STATISTICS::SymmetricStructure;
+    if (bidiagonal)
+        return STATISTICS::BidiagonalStructure;
+    if (!(fabs(A.col(0).squaredNorm() - 1) <= tol))
+        return STATISTICS::GeneralStructure;
+    Eigen::Matrix<T, 3, 3> E = -Eigen::Matrix<T, 3, 3>::Identity();
+    E.noalias() += A.transpose() * A;
+    return E.cwiseAbs().maxCoeff() <= tol ? STATISTICS::OrthogonalStructure : STATISTICS::GeneralStructure;
+}
+
+/**
+   \brief Helper function of the symmetric 3X3 SVD.
+   Jacobi rotation that zeros B(i,k) = B(k,i) of a symmetric B, B = G B G' and V = V G'.
+*/
+template <int i, int k, class T>
+inline void symmetricJacobiStep(Eigen::Matrix<T, 3, 3>& B, Eigen::Matrix<T, 3, 3>& V)
+{
+    using std::fabs;
+    using std::sqrt;
+    // t = tan of the rotation angle, the smaller root of t^2 + 2 t (B(k,k) - B(i,i)) / (2 B(i,k)) - 1 = 0
+    T d = B(k, k) - B(i, i);
+    T b = B(i, k);
+    T t = (d < 0 ? -2 * b : 2 * b) / (fabs(d) + sqrt(d * d + 4 * b * b));
+    GivensRotation<T, i, k> r;
+    r.c = JIXIE::MATH_TOOLS::rsqrt(1 + t * t);
+    r.s = t * r.c;
+
+    // Only row and column j = 3 - i - k of B change besides the 2x2 block, and B stays symmetric
+    constexpr int j = 3 - i - k;
+    T b_ij = B(i, j);
+    T b_kj = B(k, j);
+    B(i, j) = B(j, i) = r.c * b_ij - r.s * b_kj;
+    B(k, j) = B(j, k) = r.s * b_ij + r.c * b_kj;
+    B(i, i) -= t * b;
+    B(k, k) += t * b;
+    B(i, k) = 0;
+    B(k, i) = 0;
+
+    r.columnRotation(V);
+}
+
+/**
+   \brief 3X3 SVD of a symmetric A = V diag(lambda) V' by cyclic Jacobi rotations, same conventions as
+   singularValueDecomposition. Falls back to the implicit QR SVD if max_sweeps is not enough.
+   \return Number of Jacobi sweeps, plus the QR iterations of the fallback.
+
+   U starts as V, sortDiagonal then moves the signs of the eigenvalues into U. The Jacobi iteration
+   converges quadratically, so the default tol, tighter than that of the QR SVD, costs at most one more sweep.
+   A whose largest entry is outside SafeScale is scaled by a power of 2 first, like in singularValueDecomposition.
+*/
+template <class T>
+inline int symmetricSingularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
+    Eigen::Matrix<T, 3, 3>& U,
+    Eigen::Matrix<T, 3, 1>& sigma,
+    Eigen::Matrix<T, 3, 3>& V,
+    T tol = 16 * std::numeric_limits<T>::epsilon(),
+    const int max_sweeps = 6)
+{
+    using std::fabs;
+    using std::max;
+    T scale = SafeScale<T>::factor(A);
+    if (scale != 1) {
+        int sweeps = symmetricSingularValueDecomposition((scale * A).eval(), U, sigma, V, tol, max_sweeps);
+        sigma /= scale;
+        return sweeps;
+    }
 
-        process<1>(B, U, sigma, V);
-        sort<1>(U, sigma, V);
+    Eigen::Matrix<T, 3, 3> B = A;
+    V = Eigen::Matrix<T, 3, 3>::Identity();
+    tol *= max((T)0.5 * B.norm(), std::numeric_limits<T>::min());
+
+    int sweeps = 0;
+    while (max(max(fabs(B(0, 1)), fabs(B(0, 2))), fabs(B(1, 2))) > tol) {
+        if (sweeps == max_sweeps)
+            return sweeps + singularValueDecomposition(A, U, sigma, V);
+        if (fabs(B(0, 1)) > tol)
+            symmetricJacobiStep<0, 1>(B, V);
+        if (fabs(B(0, 2)) > tol)
+            symmetricJacobiStep<0, 2>(B, V);
+        if (fabs(B(1, 2)) > tol)
+            symmetricJacobiStep<1, 2>(B, V);
+        sweeps++;
     }
+    U = V;
+    sigma = B.diagonal();
+    sortDiagonal(U, sigma, V);
+    return sweeps;
+}
 
+/**
+   \brief 3X3 SVD with fast paths for structured input, same conventions as singularValueDecomposition.
+   \tparam Options Which of U and V to compute, see SVDOptions. A factor that is not computed is left untouched.
+   \return Number of QR iterations or Jacobi sweeps, 0 for diagonal and orthogonal input.
+
+   classifyStructure picks the route:
+   diagonal: sigma = diag(A), only sorted.
+   symmetric: Jacobi eigenvalue iteration, see symmetricSingularValueDecomposition.
+   bidiagonal: the QR iteration right away, makeUpperBidiag is skipped.
+   orthogonal: U = A (last column negated for a reflection), V = I, sigma = (1, 1, +-1).
+   anything else: singularValueDecomposition.
+*/
+template <int Options = ComputeUV, class T>
+inline int structuredSingularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
+    Eigen::Matrix<T, 3, 3>& U,
+    Eigen::Matrix<T, 3, 1>& sigma,
+    Eigen::Matrix<T, 3, 3>& V)
+{
+    typedef Eigen::Matrix<T, 3, 3> Matrix;
+    STATISTICS::Structure structure = classifyStructure(A);
+    STATISTICS::recordStructure(structure);
+    if (structure == STATISTICS::GeneralStructure)
+        return singularValueDecomposition<Options>(A, U, sigma, V);
+    if (structure == STATISTICS::BidiagonalStructure) {
+        Matrix B = A;
+        if (Options & ComputeU)
+            U = Matrix::Identity();
+        if (Options & ComputeV)
+            V = Matrix::Identity();
+        return bidiagonalSingularValueDecomposition<Options>(B, U, sigma, V);
+    }
+
+    // The remaining routes build both factors and copy out the ones asked for
+    Matrix U_all, V_all;
+    int count = 0;
+    if (structure == STATISTICS::DiagonalStructure) {
+        U_all = V_all = Matrix::Identity();
+        sigma = A.diagonal();
+        sortDiagonal(U_all, sigma, V_all);
+    }
+    else if (structure == STATISTICS::SymmetricStructure)
+        count = symmetricSingularValueDecomposition(A, U_all, sigma, V_all);
+    else {
+        U_all = A;
+        V_all = Matrix::Identity();
+        sigma = Eigen::Matrix<T, 3, 1>::Ones();
+        if (A.determinant() < 0) {
+            U_all.col(2) = -U_all.col(2);
+            sigma(2) = -1;
+        }
+    }
+    if (Options & ComputeU)
+        U = U_all;
+    if (Options & ComputeV)
+        V = V_all;
     return count;
 }
 
+/**
+   Engine policy for singularValueDecomposition<Engine>: structuredSingularValueDecomposition, the implicit
+   QR SVD with fast paths for diagonal, symmetric, bidiagonal and orthogonal input.
+*/
+struct Structured {
+    template <int Options, class T>
+    static inline int run(const Eigen::Matrix<T, 3, 3>& A,
+        Eigen::Matrix<T, 3, 3>& U,
+        Eigen::Matrix<T, 3, 1>& sigma,
+        Eigen::Matrix<T, 3, 3>& V)
+    {
+        return structuredSingularValueDecomposition<Options>(A, U, sigma, V);
+    }
+};
+
 /**
    \brief 3X3 polar decomposition.
    \param[in] A matrix.
@@ -873,5 +1555,224 @@ inline void polarDecomposition(const Eigen::Matrix<T, 3, 3>& A,
     R.noalias() = U * V.transpose();
     S_Sym.noalias() = V * Eigen::DiagonalMatrix<T, 3, 3>(sigma) * V.transpose();
 }
+
+/**
+   \brief 3X3 polar decomposition A = R S with S packed, otherwise the same as polarDecomposition.
+   The SVD skips the sort, which only has to keep the negative singular value on the smallest
+   magnitude, and R = U V' and S = V diag(sigma) V' share the scaled columns of V.
+   \param[in] A matrix.
+   \param[out] R Robustly a rotation matrix.
+   \param[out] S Symmetric, 6 entries.
+*/
+template <class T>
+inline void polarDecomposition(const Eigen::Matrix<T, 3, 3>& A,
+    Eigen::Matrix<T, 3, 3>& R,
+    SymmetricMatrix3<T>& S)
+{
+    Eigen::Matrix<T, 3, 3> U;
+    Eigen::Matrix<T, 3, 1> sigma;
+    Eigen::Matrix<T, 3, 3> V;
+
+    singularValueDecomposition<ComputeUV | Unsorted>(A, U, sigma, V);
+    R.noalias() = U * V.transpose();
+    Eigen::Matrix<T, 3, 3> W = V * Eigen::DiagonalMatrix<T, 3, 3>(sigma);
+    S.data[0] = W.row(0).dot(V.row(0));
+    S.data[1] = W.row(1).dot(V.row(1));
+    S.data[2] = W.row(2).dot(V.row(2));
+    S.data[3] = W.row(1).dot(V.row(2));
+    S.data[4] = W.row(0).dot(V.row(2));
+    S.data[5] = W.row(0).dot(V.row(1));
+}
+
+/**
+   \brief Helper function of the warm started 3X3 polar decomposition.
+   M = trace(S) I - sym(S) with its cofactors C and determinant det. Returns true if M is positive
+   definite by its leading principal minors, i.e. if the sum of any two eigenvalues of sym(S) is
+   positive. For a symmetric S = R' A this holds at the maximum of trace(R' A), where S is positive
+   definite but for a negative eigenvalue of the smallest magnitude if det A < 0, and fails at the
+   saddle points, where S is symmetric too.
+*/
+template <class T>
+inline bool polarTraceHessian(const Eigen::Matrix<T, 3, 3>& S, Eigen::Matrix<T, 3, 3>& C, T& det)
+{
+    Eigen::Matrix<T, 3, 3> M = S.trace() * Eigen::Matrix<T, 3, 3>::Identity() - (T)0.5 * (S + S.transpose());
+    // leading principal minors, the last one from the cofactors that also give the inverse
+    C << M(1, 1) * M(2, 2) - M(1, 2) * M(2, 1), M(0, 2) * M(2, 1) - M(0, 1) * M(2, 2), M(0, 1) * M(1, 2) - M(0, 2) * M(1, 1),
+        M(1, 2) * M(2, 0) - M(1, 0) * M(2, 2), M(0, 0) * M(2, 2) - M(0, 2) * M(2, 0), M(0, 2) * M(1, 0) - M(0, 0) * M(1, 2),
+        M(1, 0) * M(2, 1) - M(1, 1) * M(2, 0), M(0, 1) * M(2, 0) - M(0, 0) * M(2, 1), M(0, 0) * M(1, 1) - M(0, 1) * M(1, 0);
+    det = M(0, 0) * C(0, 0) + M(0, 1) * C(1, 0) + M(0, 2) * C(2, 0);
+    return M(0, 0) > 0 && C(2, 2) > 0 && det > 0;
+}
+
+/**
+   \brief Helper function of the warm started 3X3 polar decomposition.
+   Newton step on R for trace(R' A), i.e. for the symmetry of S = R' A: the small rotation w with
+   (trace(S) I - sym(S)) w = axial(S - S') symmetrizes S to first order. It is taken as the
+   rotation of the unit quaternion (w/2, 1) / |(w/2, 1)|, and applied as R = R G, S = G' S.
+   Returns false without a step if trace(S) I - sym(S) is not positive definite (see
+   polarTraceHessian), which it is near the maximum of the trace but not near a saddle point.
+*/
+template <class T>
+inline bool polarNewtonStep(Eigen::Matrix<T, 3, 3>& R, Eigen::Matrix<T, 3, 3>& S)
+{
+    Eigen::Matrix<T, 3, 3> C;
+    T det;
+    if (!polarTraceHessian(S, C, det))
+        return false;
+
+    Eigen::Matrix<T, 3, 1> axial(S(2, 1) - S(1, 2), S(0, 2) - S(2, 0), S(1, 0) - S(0, 1));
+    Eigen::Matrix<T, 3, 1> v = (C * axial) * ((T)0.5 / det);
+    T scale = MATH_TOOLS::rsqrt(1 + v.squaredNorm());
+    T w = scale;
+    T x = v(0) * scale, y = v(1) * scale, z = v(2) * scale;
+    Eigen::Matrix<T, 3, 3> G;
+    G << 1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y),
+        2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x),
+        2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y);
+    R = R * G;
+    S = G.transpose() * S;
+    return true;
+}
+
+/**
+   \brief Warm started 3X3 polar decomposition A = R S
+   \param[in] A matrix.
+   \param[in] R_hint A rotation close to R, typically R of the previous time step. Identity for a cold start,
+   which is slower but still correct. It may be a few ulps off orthogonal, one Newton-Schulz step cleans it up.
+   \param[out] R Robustly a rotation matrix. May be the same object as R_hint.
+   \param[out] S Symmetric.
+   \param[in] tol Relative to |A|, bound on the asymmetry of S, see symError in 3dPolar.h.
+   \param[in] max_sweeps Sweeps before the SVD takes over.
+   \return Number of sweeps, plus the QR iterations if the sweeps did not converge.
+
+   R starts as R_hint and S as R' A. A sweep is one Newton step (see polarNewtonStep) once
+   R is near the maximum of trace(R' A), and else the cyclic Givens sweep of 3dPolar.h, where
+   each rotation makes one pair of rows of S symmetric and maximizes its trace. The Givens sweeps
+   alone converge only linearly, the Newton steps quadratically, so from the R of the previous
+   time step one or two sweeps do. A symmetric S alone does not make the polar decomposition:
+   R_hint' A may be symmetric from the start, or the Givens sweeps may settle on a saddle point of
+   the trace, both with an indefinite S. So the result is kept only at the maximum, see
+   polarTraceHessian. Otherwise, or if max_sweeps is not enough, R and S come from the SVD of A.
+*/
+template <class T>
+inline int polarDecomposition(const Eigen::Matrix<T, 3, 3>& A,
+    const Eigen::Matrix<T, 3, 3>& R_hint,
+    Eigen::Matrix<T, 3, 3>& R,
+    Eigen::Matrix<T, 3, 3>& S,
+    T tol = 128 * std::numeric_limits<T>::epsilon(),
+    const int max_sweeps = 8)
+{
+    using std::fabs;
+    using std::max;
+    // One Newton-Schulz step R = R_hint (3 I - R_hint' R_hint) / 2, so that the rounding errors of
+    // R_hint, which is typically the R of the previous step, do not pile up from step to step
+    Eigen::Matrix<T, 3, 3> E = (T)1.5 * Eigen::Matrix<T, 3, 3>::Identity();
+    E.noalias() -= (T)0.5 * R_hint.transpose() * R_hint;
+    R = R_hint * E;
+    S.noalias() = R.transpose() * A;
+    tol *= A.norm();
+
+    auto asymmetry = [&](int i, int k) { return fabs(S(i, k) - S(k, i)); };
+    auto symError = [&]() { return max(max(asymmetry(0, 1), asymmetry(0, 2)), asymmetry(1, 2)); };
+    int sweeps = 0;
+    while (symError() > tol && sweeps < max_sweeps) {
+        if (!polarNewtonStep(R, S))
+            for (int i = 0; i < 3; i++)
+                for (int k = i + 1; k < 3; k++) {
+                    GivensRotation<T> g(S(i, i) + S(k, k), S(k, i) - S(i, k), i, k);
+                    g.columnRotation(R);
+                    g.rowRotation(S);
+                }
+        sweeps++;
+    }
+
+    Eigen::Matrix<T, 3, 3> C;
+    T det;
+    if (symError() > tol || !polarTraceHessian(S, C, det)) {
+        Eigen::Matrix<T, 3, 3> U, V;
+        Eigen::Matrix<T, 3, 1> sigma;
+        sweeps += singularValueDecomposition(A, U, sigma, V);
+        R.noalias() = U * V.transpose();
+        S.noalias() = V * Eigen::DiagonalMatrix<T, 3, 3>(sigma) * V.transpose();
+        return sweeps;
+    }
+
+    // symmetric to within tol, exactly symmetric like the other polar decompositions
+    for (int i = 0; i < 3; i++)
+        for (int k = i + 1; k < 3; k++)
+            S(i, k) = S(k, i) = (T)0.5 * (S(i, k) + S(k, i));
+    return sweeps;
+}
+
+/**
+   \brief Rotations of the polar decompositions of a set of elements, each warm starting the next
+   decomposition of its element. Elements start at the identity, i.e. cold.
+*/
+template <class T>
+class PolarRotationStore {
+public:
+    typedef Eigen::Matrix<T, 3, 3> Matrix3;
+
+    PolarRotationStore(size_t n = 0,
+        const T tol = 128 * std::numeric_limits<T>::epsilon(),
+        const int max_sweeps = 8)
+        : tol(tol)
+        , max_sweeps(max_sweeps)
+    {
+        resize(n);
+    }
+
+    /**
+       New elements start cold, existing ones keep their rotation
+    */
+    void resize(size_t n)
+    {
+        rotations.resize(n, Matrix3::Identity());
+    }
+
+    size_t size() const
+    {
+        return rotations.size();
+    }
+
+    /**
+       Cold start for every element, e.g. after a remesh
+    */
+    void reset()
+    {
+        std::fill(rotations.begin(), rotations.end(), Matrix3::Identity());
+    }
+
+    const Matrix3& rotation(size_t e) const
+    {
+        return rotations[e];
+    }
+
+    /**
+       \brief Polar decomposition F = R S of element e, warm started from and stored back into rotation(e)
+       \return Number of sweeps, see the warm started polarDecomposition.
+    */
+    int decompose(size_t e, const Matrix3& F, Matrix3& S)
+    {
+        return polarDecomposition(F, rotations[e], rotations[e], S, tol, max_sweeps);
+    }
+
+    /**
+       \brief decompose for the elements begin to end - 1, F and S are indexed by element
+       \return Total number of sweeps.
+    */
+    long decompose(size_t begin, size_t end, const Matrix3* F, Matrix3* S)
+    {
+        long sweeps = 0;
+        for (size_t e = begin; e < end; e++)
+            sweeps += decompose(e, F[e], S[e]);
+        return sweeps;
+    }
+
+private:
+    std::vector<Matrix3> rotations;
+    T tol;
+    int max_sweeps;
+};
 }
 #endif
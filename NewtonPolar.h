@@ -0,0 +1,316 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   This file implements 3D polar decompositions by matrix iterations that converge
+   to the rotation R of A = R S, see Higham, "Functions of Matrices", chapter 8.
+
+   ScaledNewton: X = (gamma X + X^-T / gamma) / 2 with the Frobenius norm scaling gamma
+      until the steps get small. Quadratic, about 7 iterations in double even for
+      condition numbers of 1e10.
+   NewtonSchulz: X = X (3 I - X'X) / 2. Only multiplications, but the smallest singular
+      value only grows by 3/2 per iteration, so it is meant for A close to a rotation.
+
+   X starts as A scaled to a root mean square singular value of 1. Every iterate has the
+   singular vectors of A, so X'A is symmetric up to rounding from the first iteration on
+   and the symError test of 3dPolar.h cannot tell convergence. Instead each step returns
+   a squared error e of the current X, the size of the Newton step or |X'X - I|^2 for
+   Newton-Schulz, and the iteration stops once e <= tol, which makes the new X about tol / 2
+   away from R. Then S is the symmetric part of R'A.
+
+   If det(A) <= 0 (no rotation is a polar factor) or the iteration does not converge, the
+   result comes from the SVD based polarDecomposition. So it does if det of the scaled A is
+   below sqrt(epsilon): the error R S - A then grows like epsilon / sqrt(det), past that of
+   the SVD.
+
+   Eigen::Matrix<T, 3, 3> A, R, S;
+   int iterations = JIXIE::iterativePolarDecomposition<JIXIE::ScaledNewton>(A, R, S); // or JIXIE::NewtonSchulz
+   // Same R and S as JIXIE::polarDecomposition, iterations is -1 if the SVD was used
+
+   JIXIE::MatrixStreams<T, 3, 3> A(n), R(n);
+   JIXIE::MatrixStreams<T, 6, 1> S(n); // entries 00, 11, 22, 12, 02, 01 of S, like SymmetricMatrix3
+   JIXIE::batchIterativePolarDecomposition<JIXIE::NewtonSchulz>(n, A.streams(), R.streams(), S.streams());
+   ################################################################################
+*/
+
+#ifndef JIXIE_NEWTON_POLAR_H
+#define JIXIE_NEWTON_POLAR_H
+
+#include "ImplicitQRSVD.h"
+#include "BatchSVD.h"
+
+namespace JIXIE {
+
+namespace NEWTON_POLAR {
+
+/**
+   \brief Cofactor matrix C = det(X) X^-T, whose columns are the cross products of the columns of X, and det(X)
+*/
+template <class Matrix, class T>
+inline void cofactor(const Matrix& X, Matrix& C, T& det)
+{
+    for (int j = 0; j < 3; j++) {
+        const int k = (j + 1) % 3, l = (j + 2) % 3;
+        C(0, j) = X(1, k) * X(2, l) - X(2, k) * X(1, l);
+        C(1, j) = X(2, k) * X(0, l) - X(0, k) * X(2, l);
+        C(2, j) = X(0, k) * X(1, l) - X(1, k) * X(0, l);
+    }
+    det = X(0, 0) * C(0, 0) + X(1, 0) * C(1, 0) + X(2, 0) * C(2, 0);
+}
+
+/**
+   \brief Sum of squares of the entries
+*/
+template <class Matrix>
+inline auto squaredNorm(const Matrix& X) -> typename std::decay<decltype(X(0, 0))>::type
+{
+    auto s = X(0, 0) * X(0, 0);
+    for (int k = 1; k < 9; k++)
+        s += X(k % 3, k / 3) * X(k % 3, k / 3);
+    return s;
+}
+
+/**
+   \brief Entry (i,j) of the symmetric part of X'A
+*/
+template <class Matrix>
+inline auto symmetricProduct(const Matrix& X, const Matrix& A, const int i, const int j) -> typename std::decay<decltype(X(0, 0))>::type
+{
+    auto s = X(0, i) * A(0, j) + X(0, j) * A(0, i);
+    for (int k = 1; k < 3; k++)
+        s += X(k, i) * A(k, j) + X(k, j) * A(k, i);
+    return s * 0.5f;
+}
+}
+
+/**
+   Scaled Newton iteration X = (gamma X + X^-T / gamma) / 2, with X^-T = C / det(X) from the cofactor matrix.
+   gamma = sqrt(|X^-1| / |X|) in the Frobenius norm until a step of squared size 1e-2, 1 after.
+*/
+struct ScaledNewton {
+    static constexpr int max_iterations = 20;
+
+    template <class T>
+    static T tolerance()
+    {
+        return 4 * std::numeric_limits<T>::epsilon();
+    }
+
+    /**
+       One iteration on X, returning the squared Frobenius norm of the step.
+       scaling is cleared once the steps get small.
+    */
+    template <class T>
+    static T step(Eigen::Matrix<T, 3, 3>& X, bool& scaling)
+    {
+        using std::sqrt;
+        Eigen::Matrix<T, 3, 3> C;
+        T det;
+        NEWTON_POLAR::cofactor(X, C, det);
+        T gamma = scaling ? sqrt(sqrt(C.squaredNorm() / X.squaredNorm()) / det) : 1;
+        Eigen::Matrix<T, 3, 3> next = (T)0.5 * (gamma * X + C / (gamma * det));
+        T step = (next - X).squaredNorm();
+        X = next;
+        scaling = scaling && step > (T)1e-2;
+        return step;
+    }
+
+    /**
+       One iteration on all the lanes of X, see the scalar version
+    */
+    template <class P>
+    static typename P::Vec step(SIMD::Matrix3<P>& X, typename P::Mask& scaling)
+    {
+        using Vec = typename P::Vec;
+        SIMD::Matrix3<P> C;
+        Vec det;
+        NEWTON_POLAR::cofactor(X, C, det);
+        Vec gamma = P::select(scaling, P::sqrt(P::sqrt(NEWTON_POLAR::squaredNorm(C) / NEWTON_POLAR::squaredNorm(X)) / det), P::broadcast(1));
+        Vec half_gamma = P::broadcast(0.5) * gamma, half_inverse = P::broadcast(0.5) / (gamma * det);
+        Vec step = P::broadcast(0);
+        for (int k = 0; k < 9; k++) {
+            Vec next = half_gamma * X.m[k] + half_inverse * C.m[k];
+            step += (next - X.m[k]) * (next - X.m[k]);
+            X.m[k] = next;
+        }
+        scaling &= step > P::broadcast((typename P::Scalar)1e-2);
+        return step;
+    }
+};
+
+/**
+   Newton-Schulz iteration X = X (3 I - X'X) / 2. It converges if all singular values of X are in (0, sqrt(3)),
+   which the scaling of the first X makes sure of, but slowly unless they are close to 1.
+*/
+struct NewtonSchulz {
+    static constexpr int max_iterations = 32;
+
+    template <class T>
+    static T tolerance()
+    {
+        return 4 * std::numeric_limits<T>::epsilon();
+    }
+
+    /**
+       One iteration on X, returning |X'X - I|^2 in the Frobenius norm before it.
+       The size of the step would be no measure of convergence, tiny singular values stay tiny.
+    */
+    template <class T>
+    static T step(Eigen::Matrix<T, 3, 3>& X, bool&)
+    {
+        Eigen::Matrix<T, 3, 3> G = X.transpose() * X - Eigen::Matrix<T, 3, 3>::Identity();
+        X -= (T)0.5 * X * G;
+        return G.squaredNorm();
+    }
+
+    /**
+       One iteration on all the lanes of X, see the scalar version
+    */
+    template <class P>
+    static typename P::Vec step(SIMD::Matrix3<P>& X, typename P::Mask&)
+    {
+        using Vec = typename P::Vec;
+        // G = X'X - I, symmetric
+        Vec G[3][3];
+        Vec error = P::broadcast(0);
+        for (int i = 0; i < 3; i++)
+            for (int j = i; j < 3; j++) {
+                Vec g = X(0, i) * X(0, j) + X(1, i) * X(1, j) + X(2, i) * X(2, j);
+                G[i][j] = G[j][i] = i == j ? g - P::broadcast(1) : g;
+                error += (i == j ? P::broadcast(1) : P::broadcast(2)) * G[i][j] * G[i][j];
+            }
+        for (int i = 0; i < 3; i++) {
+            Vec row[3] = { X(i, 0), X(i, 1), X(i, 2) };
+            for (int j = 0; j < 3; j++)
+                X(i, j) = row[j] - P::broadcast(0.5) * (row[0] * G[0][j] + row[1] * G[1][j] + row[2] * G[2][j]);
+        }
+        return error;
+    }
+};
+
+/**
+   \brief 3X3 polar decomposition A = R S by a matrix iteration, see the top of the file.
+   \tparam Engine ScaledNewton or NewtonSchulz.
+   \param[in] A matrix.
+   \param[out] R Robustly a rotation matrix.
+   \param[out] S Symmetric. Only the smallest eigenvalue can be negative, and only if det(A) < 0.
+   \param[in] tol Bound on the squared error of the last iterate but one, see the top of the file.
+   \return The number of iterations, -1 if the result comes from the SVD.
+*/
+template <class Engine, class T>
+inline int iterativePolarDecomposition(const Eigen::Matrix<T, 3, 3>& A,
+    Eigen::Matrix<T, 3, 3>& R,
+    Eigen::Matrix<T, 3, 3>& S,
+    const T tol = Engine::template tolerance<T>())
+{
+    using std::sqrt;
+    T norm2 = A.squaredNorm();
+    Eigen::Matrix<T, 3, 3> X = A * sqrt(3 / norm2);
+    // also false for NaN, and for 0 or inf when norm2 over or underflows
+    if (X.determinant() > sqrt(std::numeric_limits<T>::epsilon())) {
+        bool scaling = true;
+        for (int it = 1; it <= Engine::max_iterations; it++)
+            if (Engine::step(X, scaling) <= tol) {
+                R = X;
+                for (int i = 0; i < 3; i++)
+                    for (int j = i; j < 3; j++)
+                        S(i, j) = S(j, i) = NEWTON_POLAR::symmetricProduct(X, A, i, j);
+                return it;
+            }
+    }
+    polarDecomposition(A, R, S);
+    return -1;
+}
+
+namespace SIMD {
+
+/**
+   \brief iterativePolarDecomposition on all the lanes of A. S gets the entries 00, 11, 22, 12, 02, 01.
+   Returns the number of iterations per lane, -1 on the lanes left to the SVD, whose R and S are garbage.
+   Lanes that converged are masked out of the remaining iterations.
+*/
+template <class Engine, class P>
+inline typename P::Vec iterativePolarDecomposition(const Matrix3<P>& A, Matrix3<P>& R, typename P::Vec S[6], const typename P::Scalar tol)
+{
+    using T = typename P::Scalar;
+    using Vec = typename P::Vec;
+    using Mask = typename P::Mask;
+
+    Vec scale = P::sqrt(P::broadcast(3) / NEWTON_POLAR::squaredNorm(A));
+    Matrix3<P> X, C;
+    for (int k = 0; k < 9; k++)
+        X.m[k] = A.m[k] * scale;
+    Vec det;
+    NEWTON_POLAR::cofactor(X, C, det);
+    Mask active = det > P::broadcast(std::sqrt(std::numeric_limits<T>::epsilon()));
+    Mask scaling = active;
+    Vec count = P::broadcast(-1);
+    for (int it = 1; it <= Engine::max_iterations && P::any(active); it++) {
+        Matrix3<P> next = X;
+        Vec step = Engine::step(next, scaling);
+        for (int k = 0; k < 9; k++)
+            X.m[k] = P::select(active, next.m[k], X.m[k]);
+        Mask converged = active & (step <= P::broadcast(tol));
+        count = P::select(converged, P::broadcast(it), count);
+        active &= ~converged;
+    }
+
+    R = X;
+    for (int k = 0; k < 6; k++)
+        S[k] = NEWTON_POLAR::symmetricProduct(X, A, SymmetricMatrix3<T>::row(k), SymmetricMatrix3<T>::col(k));
+    return count;
+}
+}
+
+/**
+   \brief Batched iterativePolarDecomposition on structure-of-arrays data.
+   \param[in] n Number of matrices.
+   \param[in] A 9 input streams in column major order.
+   \param[out] R 9 output streams. Every R is a rotation matrix.
+   \param[out] S 6 output streams with the entries 00, 11, 22, 12, 02, 01 of S, the order of SymmetricMatrix3.
+   \param[out] count Optional number of iterations per matrix, -1 if the result comes from the SVD.
+
+   The lanes that need the SVD go through the scalar polarDecomposition after their pack.
+   W is the number of SIMD lanes and defaults to the widest enabled register.
+*/
+template <class Engine, class T, int W = SIMD::NativeWidth<T>::value>
+inline void batchIterativePolarDecomposition(const size_t n,
+    const T* const A[9],
+    T* const R[9],
+    T* const S[6],
+    int* count = nullptr,
+    const T tol = Engine::template tolerance<T>())
+{
+    using P = SIMD::Pack<T, W>;
+    SIMD::batchPolarDecomposition<P>(n, A, R, S, count, [tol](const SIMD::Matrix3<P>& a, SIMD::Matrix3<P>& r, typename P::Vec s[6]) {
+        return SIMD::iterativePolarDecomposition<Engine>(a, r, s, tol);
+    });
+}
+}
+#endif
@@ -0,0 +1,162 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   This file implements multi-threaded 3D SVDs and polar decompositions over
+   large arrays of matrices.
+
+   JIXIE::ThreadPool pool;  // create once, reuse for every batch
+   std::vector<Eigen::Matrix<T, 3, 3> > A(n), U(n), V(n), R(n), S(n);
+   std::vector<Eigen::Matrix<T, 3, 1> > sigma(n);
+   JIXIE::parallelSingularValueDecomposition(pool, n, A.data(), U.data(), sigma.data(), V.data());
+   JIXIE::parallelPolarDecomposition(pool, n, A.data(), R.data(), S.data());
+   // or with std::vector<JIXIE::SymmetricMatrix3<T> > S(n), 6 numbers per S
+
+   // time stepping, each element warm started from its rotation of the previous step
+   JIXIE::PolarRotationStore<T> store(n);
+   long sweeps = JIXIE::parallelPolarDecomposition(pool, store, n, F.data(), S.data());
+
+   // structure-of-arrays data goes through the SIMD kernel of BatchSVD.h
+   JIXIE::parallelBatchSingularValueDecomposition(pool, n, A_streams, U_streams, sigma_streams, V_streams);
+
+   The grain is the number of matrices handed to a thread at a time.
+   ################################################################################
+*/
+
+#ifndef JIXIE_PARALLEL_SVD_H
+#define JIXIE_PARALLEL_SVD_H
+
+#include "ImplicitQRSVD.h"
+#include "BatchSVD.h"
+#include "ThreadPool.h"
+#include <numeric>
+
+namespace JIXIE {
+
+/**
+   \brief 3X3 SVD of n matrices stored as arrays of Eigen matrices, see singularValueDecomposition.
+*/
+template <class T>
+inline void parallelSingularValueDecomposition(ThreadPool& pool,
+    const size_t n,
+    const Eigen::Matrix<T, 3, 3>* A,
+    Eigen::Matrix<T, 3, 3>* U,
+    Eigen::Matrix<T, 3, 1>* sigma,
+    Eigen::Matrix<T, 3, 3>* V,
+    const size_t grain = 4096)
+{
+    pool.parallelFor(n, grain, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++)
+            singularValueDecomposition(A[i], U[i], sigma[i], V[i]);
+    });
+}
+
+/**
+   \brief 3X3 polar decomposition of n matrices stored as arrays of Eigen matrices, see polarDecomposition.
+*/
+template <class T>
+inline void parallelPolarDecomposition(ThreadPool& pool,
+    const size_t n,
+    const Eigen::Matrix<T, 3, 3>* A,
+    Eigen::Matrix<T, 3, 3>* R,
+    Eigen::Matrix<T, 3, 3>* S_Sym,
+    const size_t grain = 4096)
+{
+    pool.parallelFor(n, grain, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++)
+            polarDecomposition(A[i], R[i], S_Sym[i]);
+    });
+}
+
+/**
+   \brief 3X3 polar decomposition of n matrices with S packed, see polarDecomposition.
+*/
+template <class T>
+inline void parallelPolarDecomposition(ThreadPool& pool,
+    const size_t n,
+    const Eigen::Matrix<T, 3, 3>* A,
+    Eigen::Matrix<T, 3, 3>* R,
+    SymmetricMatrix3<T>* S_Sym,
+    const size_t grain = 4096)
+{
+    pool.parallelFor(n, grain, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++)
+            polarDecomposition(A[i], R[i], S_Sym[i]);
+    });
+}
+
+/**
+   \brief Warm started 3X3 polar decomposition of the n elements of store, see PolarRotationStore::decompose.
+   \return Total number of sweeps.
+*/
+template <class T>
+inline long parallelPolarDecomposition(ThreadPool& pool,
+    PolarRotationStore<T>& store,
+    const size_t n,
+    const Eigen::Matrix<T, 3, 3>* F,
+    Eigen::Matrix<T, 3, 3>* S_Sym,
+    const size_t grain = 4096)
+{
+    std::vector<long> sweeps(pool.size(), 0);
+    pool.parallelFor(n, grain, [&](size_t begin, size_t end, int thread) {
+        sweeps[thread] += store.decompose(begin, end, F, S_Sym);
+    });
+    return std::accumulate(sweeps.begin(), sweeps.end(), 0L);
+}
+
+/**
+   \brief Batched 3X3 SVD of structure-of-arrays data, see batchSingularValueDecomposition.
+   The grain is rounded up to a multiple of the SIMD width so only the very last chunk is padded.
+*/
+template <class T, int W = SIMD::NativeWidth<T>::value>
+inline void parallelBatchSingularValueDecomposition(ThreadPool& pool,
+    const size_t n,
+    const T* const A[9],
+    T* const U[9],
+    T* const sigma[3],
+    T* const V[9],
+    int* count = nullptr,
+    size_t grain = 4096)
+{
+    grain = (grain + W - 1) / W * W;
+    pool.parallelFor(n, grain, [&](size_t begin, size_t end, int) {
+        const T* a[9];
+        T *u[9], *s[3], *v[9];
+        for (int k = 0; k < 9; k++) {
+            a[k] = A[k] + begin;
+            u[k] = U[k] + begin;
+            v[k] = V[k] + begin;
+        }
+        for (int k = 0; k < 3; k++)
+            s[k] = sigma[k] + begin;
+        batchSingularValueDecomposition<T, W>(end - begin, a, u, s, v, count ? count + begin : nullptr);
+    });
+}
+}
+#endif
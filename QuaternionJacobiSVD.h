@@ -0,0 +1,237 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   This file implements a fixed sweep Jacobi 3D SVD, following
+   McAdams et al. 2011, "Computing the Singular Value Decomposition of 3x3 matrices
+   with minimal branching and elementary floating point operations".
+
+   1. A fixed number of cyclic Jacobi sweeps diagonalize A'A. The rotations are
+      accumulated into a quaternion, which gives V.
+   2. The columns of AV are sorted by decreasing norm.
+   3. Givens QR of AV gives U and sigma, which a last sort puts in order where the
+      column norms of AV were off by a few ulps.
+
+   Unlike the implicit QR engine, the amount of work does not depend on A and there are
+   no special cases, only selects. T may be float or double.
+   Forming A'A squares the condition number, so for nearly rank deficient matrices V, and with it
+   the reconstruction, is less accurate than with the implicit QR engine. Measured on 2^20 cases
+   of the SpectrumCases families of TestCases.h, the reconstruction error |A - U sigma V'| is up
+   to about 1500 ulps of |A| in float and 3e7 ulps in double for the ill_conditioned and
+   near_rank1 families, against up to 100 ulps in float and 7 ulps in double for the others.
+
+   Eigen::Matrix<T, 3, 3> A, U, V;
+   Eigen::Matrix<T, 3, 1> S;
+   JIXIE::singularValueDecomposition<JIXIE::QuaternionJacobi>(A, U, S, V);
+   // Same conventions as JIXIE::singularValueDecomposition
+   ################################################################################
+*/
+
+#ifndef JIXIE_QUATERNION_JACOBI_SVD_H
+#define JIXIE_QUATERNION_JACOBI_SVD_H
+
+#include "ImplicitQRSVD.h"
+
+namespace JIXIE {
+
+namespace QUATERNION_JACOBI {
+
+/**
+   \brief One Jacobi rotation of the symmetric matrix S zeroing S(p,q), with (p,q,k) a cyclic permutation of (0,1,2).
+   The rotation J = ( c s ; -s c ) in the p,q plane is applied as S = J' S J and accumulated as q = q * (ch, -sh e_k),
+   where (w,x,y,z) = (q(3),q(0),q(1),q(2)) and (ch, sh) = (cos, sin) of half the rotation angle.
+*/
+template <int p, int q, int k, class T>
+inline void jacobiConjugation(Eigen::Matrix<T, 3, 3>& S, Eigen::Matrix<T, 4, 1>& quaternion)
+{
+    using std::fabs;
+    using std::sqrt;
+    using std::copysign;
+
+    // t = s / c, the smaller root of t^2 + 2 tau t - 1 = 0 with tau = (S(q,q) - S(p,p)) / (2 S(p,q)), see Golub and Van Loan.
+    // The min term only matters if S(p,q) = 0 and S(p,p) = S(q,q), where it makes t = 0 instead of nan.
+    T d = S(q, q) - S(p, p);
+    T t = copysign((T)2, d) * S(p, q) / (fabs(d) + sqrt(d * d + 4 * S(p, q) * S(p, q)) + std::numeric_limits<T>::min());
+    T c = JIXIE::MATH_TOOLS::rsqrt(1 + t * t);
+    T s = t * c;
+
+    T s_pk = S(p, k);
+    T s_qk = S(q, k);
+    S(p, p) -= t * S(p, q);
+    S(q, q) += t * S(p, q);
+    S(p, q) = S(q, p) = 0;
+    S(p, k) = S(k, p) = c * s_pk - s * s_qk;
+    S(q, k) = S(k, q) = s * s_pk + c * s_qk;
+
+    // tan of the half angle is s / (1 + c)
+    T h = s / (1 + c);
+    T ch = JIXIE::MATH_TOOLS::rsqrt(1 + h * h);
+    T sh = h * ch;
+
+    // J rotates by minus the angle around e_k
+    T vw = quaternion(3);
+    T vp = quaternion(p);
+    T vq = quaternion(q);
+    T vk = quaternion(k);
+    quaternion(p) = ch * vp - sh * vq;
+    quaternion(q) = ch * vq + sh * vp;
+    quaternion(k) = ch * vk - sh * vw;
+    quaternion(3) = ch * vw + sh * vk;
+}
+
+/**
+   \brief Rotation matrix of the quaternion (x,y,z,w), which does not need to be normalized.
+*/
+template <class T>
+inline void quaternionToMatrix(Eigen::Matrix<T, 4, 1> quaternion, Eigen::Matrix<T, 3, 3>& V)
+{
+    quaternion *= JIXIE::MATH_TOOLS::rsqrt(quaternion.squaredNorm());
+    T x = quaternion(0), y = quaternion(1), z = quaternion(2), w = quaternion(3);
+    V << 1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y),
+        2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x),
+        2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y);
+}
+
+/**
+   \brief Swap columns i and k of B and V if swap is set, negating the new column k so V stays a rotation.
+*/
+template <class T>
+inline void conditionalNegativeSwap(const bool swap, int i, int k, Eigen::Matrix<T, 3, 3>& B, Eigen::Matrix<T, 3, 3>& V, T& norm_i, T& norm_k)
+{
+    for (int r = 0; r < 3; r++) {
+        T b = B(r, i), v = V(r, i);
+        B(r, i) = swap ? B(r, k) : b;
+        B(r, k) = swap ? -b : B(r, k);
+        V(r, i) = swap ? V(r, k) : v;
+        V(r, k) = swap ? -v : V(r, k);
+    }
+    T n = norm_i;
+    norm_i = swap ? norm_k : n;
+    norm_k = swap ? n : norm_k;
+}
+
+/**
+   \brief Swap sigma(i) and sigma(k) and columns i and k of U and V if swap is set, negating the new
+   columns k of both so that U and V stay rotations and U sigma V' does not change.
+*/
+template <int Options, class T>
+inline void conditionalSigmaSwap(const bool swap, int i, int k, Eigen::Matrix<T, 3, 3>& U, Eigen::Matrix<T, 3, 1>& sigma, Eigen::Matrix<T, 3, 3>& V)
+{
+    for (int r = 0; r < 3; r++) {
+        if (Options & ComputeU) {
+            T u = U(r, i);
+            U(r, i) = swap ? U(r, k) : u;
+            U(r, k) = swap ? -u : U(r, k);
+        }
+        T v = V(r, i);
+        V(r, i) = swap ? V(r, k) : v;
+        V(r, k) = swap ? -v : V(r, k);
+    }
+    T s = sigma(i);
+    sigma(i) = swap ? sigma(k) : s;
+    sigma(k) = swap ? s : sigma(k);
+}
+}
+
+/**
+   Engine policy for singularValueDecomposition<Engine>: fixed sweep quaternion Jacobi SVD.
+   Returns the number of sweeps, which is always sweeps<T>().
+   Jacobi converges quadratically, three sweeps reach the accuracy of the implicit QR engine in float and four in double
+   for well conditioned A.
+*/
+struct QuaternionJacobi {
+    template <class T>
+    static constexpr int sweeps()
+    {
+        return sizeof(T) > 4 ? 4 : 3;
+    }
+
+    template <int Options, class T>
+    static inline int run(const Eigen::Matrix<T, 3, 3>& A,
+        Eigen::Matrix<T, 3, 3>& U,
+        Eigen::Matrix<T, 3, 1>& sigma,
+        Eigen::Matrix<T, 3, 3>& V_out)
+    {
+        using namespace QUATERNION_JACOBI;
+
+        Eigen::Matrix<T, 3, 3> S = A.transpose() * A;
+        Eigen::Matrix<T, 4, 1> quaternion(0, 0, 0, 1);
+        for (int sweep = 0; sweep < sweeps<T>(); sweep++) {
+            jacobiConjugation<0, 1, 2>(S, quaternion);
+            jacobiConjugation<1, 2, 0>(S, quaternion);
+            jacobiConjugation<2, 0, 1>(S, quaternion);
+        }
+
+        Eigen::Matrix<T, 3, 3> V;
+        quaternionToMatrix(quaternion, V);
+        Eigen::Matrix<T, 3, 3> B = A * V;
+
+        // Sort by the squared column norms of B, i.e. the diagonal of V'A'AV
+        T norm_0 = B.col(0).squaredNorm(), norm_1 = B.col(1).squaredNorm(), norm_2 = B.col(2).squaredNorm();
+        conditionalNegativeSwap(norm_0 < norm_1, 0, 1, B, V, norm_0, norm_1);
+        conditionalNegativeSwap(norm_0 < norm_2, 0, 2, B, V, norm_0, norm_2);
+        conditionalNegativeSwap(norm_1 < norm_2, 1, 2, B, V, norm_1, norm_2);
+
+        // QR of B. R(0,0) and R(1,1) come out non-negative, only R(2,2) may be negative.
+        GivensRotation<T, 0, 1> r1(B(0, 0), B(1, 0));
+        r1.rowRotation(B);
+        GivensRotation<T, 0, 2> r2(B(0, 0), B(2, 0));
+        r2.rowRotation(B);
+        GivensRotation<T, 1, 2> r3(B(1, 1), B(2, 1));
+        r3.rowRotation(B);
+        sigma << B(0, 0), B(1, 1), B(2, 2);
+
+        if (Options & ComputeU) {
+            U = Eigen::Matrix<T, 3, 3>::Identity();
+            r1.columnRotation(U);
+            r2.columnRotation(U);
+            r3.columnRotation(U);
+        }
+
+        // The column norms of B are only close to sigma, clustered singular values can come out of QR
+        // a few ulps out of order. Sort them, keeping the negative sign on sigma(2).
+        using std::fabs;
+        conditionalSigmaSwap<Options>(sigma(0) < sigma(1), 0, 1, U, sigma, V);
+        conditionalSigmaSwap<Options>(sigma(1) < fabs(sigma(2)), 1, 2, U, sigma, V);
+        bool flip = sigma(1) < 0;
+        sigma(1) = flip ? -sigma(1) : sigma(1);
+        sigma(2) = flip ? -sigma(2) : sigma(2);
+        if (Options & ComputeU)
+            for (int r = 0; r < 3; r++) {
+                U(r, 1) = flip ? -U(r, 1) : U(r, 1);
+                U(r, 2) = flip ? -U(r, 2) : U(r, 2);
+            }
+        conditionalSigmaSwap<Options>(sigma(0) < sigma(1), 0, 1, U, sigma, V);
+        if (Options & ComputeV)
+            V_out = V;
+        return sweeps<T>();
+    }
+};
+}
+#endif
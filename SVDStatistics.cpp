@@ -0,0 +1,116 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   The counters of the threads for SVDStatistics.h, out of line so that only this
+   translation unit, built for the baseline instruction set, has the constructors and
+   destructors of the thread slots and the registry. Empty unless JIXIE_SVD_STATISTICS
+   is defined.
+   ################################################################################
+*/
+
+#include "SVDStatistics.h"
+
+#ifdef JIXIE_SVD_STATISTICS
+
+#include <mutex>
+#include <vector>
+
+namespace JIXIE {
+namespace STATISTICS {
+namespace INTERNAL {
+namespace {
+
+/**
+   Counters of the live threads, plus what the threads that exited left behind
+*/
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadCounters*> threads;
+    Statistics retired;
+};
+
+Registry& registry()
+{
+    static Registry r;
+    return r;
+}
+
+/**
+   Registers the counters of a thread on creation and retires them when the thread exits
+*/
+struct ThreadSlot {
+    ThreadCounters counters;
+
+    ThreadSlot()
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.threads.push_back(&counters);
+    }
+
+    ~ThreadSlot()
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.retired += counters.snapshot();
+        r.threads.erase(std::remove(r.threads.begin(), r.threads.end(), &counters), r.threads.end());
+    }
+};
+}
+
+ThreadCounters& local()
+{
+    thread_local ThreadSlot slot;
+    return slot.counters;
+}
+}
+
+Statistics collect()
+{
+    INTERNAL::Registry& r = INTERNAL::registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    Statistics s = r.retired;
+    for (const INTERNAL::ThreadCounters* c : r.threads)
+        s += c->snapshot();
+    return s;
+}
+
+void reset()
+{
+    INTERNAL::Registry& r = INTERNAL::registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.retired = Statistics();
+    for (INTERNAL::ThreadCounters* c : r.threads)
+        c->reset();
+}
+}
+}
+
+#endif
@@ -0,0 +1,345 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   This file collects statistics of the 3D SVD: the number of QR iterations, which
+   degenerate case ended the iteration, which case the final sort took and, for the
+   Structured engine, which structure the input had.
+
+   Everything is compiled out unless JIXIE_SVD_STATISTICS is defined, in which case
+   every thread counts into its own counters and collect() merges them on demand.
+   The counters of the threads live in SVDStatistics.cpp, which must then be linked in.
+   It is built for the baseline instruction set, so the kernels of every variant of
+   DispatchKernels.cpp count into the same counters, and JIXIE_SVD_STATISTICS must be
+   defined the same way for every translation unit.
+
+   JIXIE::STATISTICS::reset();
+   ... singularValueDecomposition / batchSingularValueDecomposition on any thread ...
+   std::cout << JIXIE::STATISTICS::collect();
+   ################################################################################
+*/
+
+#ifndef JIXIE_SVD_STATISTICS_H
+#define JIXIE_SVD_STATISTICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+namespace JIXIE {
+namespace STATISTICS {
+
+/**
+   Whether the hooks below count, i.e. whether JIXIE_SVD_STATISTICS is defined
+*/
+#ifdef JIXIE_SVD_STATISTICS
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+/**
+   The branch of the 3X3 SVD taken after the QR iteration, named after the entry of B that is small
+*/
+enum Branch {
+    SmallBeta2,
+    SmallBeta1,
+    SmallAlpha2,
+    SmallAlpha3,
+    SmallAlpha1,
+    BranchCount
+};
+
+/**
+   The case of sort<0> and sort<1>, named after the permutation of the singular values
+*/
+enum SortCase {
+    Sort0InOrder, // sigma(0) > |sigma(1)| >= |sigma(2)|
+    Sort0MoveLastToFront, // |sigma(2)| >= sigma(0) > |sigma(1)|
+    Sort0SwapLastTwo, // sigma(0) >= |sigma(2)| > |sigma(1)|
+    Sort1InOrder, // |sigma(0)| >= sigma(1) > |sigma(2)|
+    Sort1MoveFirstToBack, // sigma(1) > |sigma(2)| >= |sigma(0)|
+    Sort1SwapFirstTwo, // sigma(1) >= |sigma(0)| > |sigma(2)|
+    SortCaseCount
+};
+
+/**
+   The structure classifyStructure found in the input of the Structured engine, see its fast paths
+*/
+enum Structure {
+    GeneralStructure, // none of the below, full implicit QR SVD
+    DiagonalStructure, // off diagonal entries exactly 0
+    SymmetricStructure, // A = A' exactly
+    BidiagonalStructure, // upper bidiagonal exactly, makeUpperBidiag is skipped
+    OrthogonalStructure, // A' A = I up to a few ulps, a rotation or a reflection
+    StructureCount
+};
+
+/**
+   Iteration counts of histogram_size - 1 and more share the last bin
+*/
+constexpr int histogram_size = 32;
+
+/**
+   \brief Merged statistics, a plain snapshot of the counters
+*/
+struct Statistics {
+    uint64_t calls = 0;
+    uint64_t iterations = 0;
+    uint64_t histogram[histogram_size] = {};
+    uint64_t branches[BranchCount] = {};
+    uint64_t sort_cases[SortCaseCount] = {};
+    uint64_t structures[StructureCount] = {};
+
+    Statistics& operator+=(const Statistics& s)
+    {
+        calls += s.calls;
+        iterations += s.iterations;
+        for (int i = 0; i < histogram_size; i++)
+            histogram[i] += s.histogram[i];
+        for (int i = 0; i < BranchCount; i++)
+            branches[i] += s.branches[i];
+        for (int i = 0; i < SortCaseCount; i++)
+            sort_cases[i] += s.sort_cases[i];
+        for (int i = 0; i < StructureCount; i++)
+            structures[i] += s.structures[i];
+        return *this;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const Statistics& s)
+{
+    static const char* branch_names[BranchCount] = { "beta_2", "beta_1", "alpha_2", "alpha_3", "alpha_1" };
+    static const char* sort_names[SortCaseCount] = { "sort0 in order", "sort0 last to front", "sort0 swap last two",
+        "sort1 in order", "sort1 first to back", "sort1 swap first two" };
+    static const char* structure_names[StructureCount] = { "general", "diagonal", "symmetric", "bidiagonal", "orthogonal" };
+    double calls = (double)std::max<uint64_t>(s.calls, 1);
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::setprecision(4) << "svd calls: " << s.calls << ", QR iterations per call: " << s.iterations / calls << std::endl;
+    out << "iterations histogram:";
+    int last = histogram_size - 1;
+    while (last > 0 && s.histogram[last] == 0)
+        last--;
+    for (int i = 0; i <= last; i++)
+        out << " " << i << (i == histogram_size - 1 ? "+" : "") << ":" << s.histogram[i];
+    out << std::endl
+        << "small entry:";
+    for (int i = 0; i < BranchCount; i++)
+        out << " " << branch_names[i] << " " << 100 * s.branches[i] / calls << "%";
+    out << std::endl
+        << "sort case:";
+    for (int i = 0; i < SortCaseCount; i++)
+        out << " " << sort_names[i] << " " << 100 * s.sort_cases[i] / calls << "%";
+    out << std::endl;
+    // The fast paths skip the QR iteration, so their hit rates are relative to the classified calls
+    uint64_t classified = 0;
+    for (int i = 0; i < StructureCount; i++)
+        classified += s.structures[i];
+    if (classified) {
+        out << "structure of " << classified << " classified calls:";
+        for (int i = 0; i < StructureCount; i++)
+            out << " " << structure_names[i] << " " << 100 * s.structures[i] / (double)classified << "%";
+        out << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+    return out;
+}
+
+namespace INTERNAL {
+
+/**
+   Counter written by one thread and read by any. Relaxed load and store instead of
+   fetch_add, so an increment is a plain add without a lock prefix.
+*/
+class Counter {
+public:
+    Counter()
+        : value(0)
+    {
+    }
+
+    void add(const uint64_t n)
+    {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    uint64_t get() const
+    {
+        return value.load(std::memory_order_relaxed);
+    }
+
+    void reset()
+    {
+        value.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> value;
+};
+
+struct ThreadCounters {
+    Counter calls;
+    Counter iterations;
+    Counter histogram[histogram_size];
+    Counter branches[BranchCount];
+    Counter sort_cases[SortCaseCount];
+    Counter structures[StructureCount];
+
+    Statistics snapshot() const
+    {
+        Statistics s;
+        s.calls = calls.get();
+        s.iterations = iterations.get();
+        for (int i = 0; i < histogram_size; i++)
+            s.histogram[i] = histogram[i].get();
+        for (int i = 0; i < BranchCount; i++)
+            s.branches[i] = branches[i].get();
+        for (int i = 0; i < SortCaseCount; i++)
+            s.sort_cases[i] = sort_cases[i].get();
+        for (int i = 0; i < StructureCount; i++)
+            s.structures[i] = structures[i].get();
+        return s;
+    }
+
+    void reset()
+    {
+        calls.reset();
+        iterations.reset();
+        for (auto& c : histogram)
+            c.reset();
+        for (auto& c : branches)
+            c.reset();
+        for (auto& c : sort_cases)
+            c.reset();
+        for (auto& c : structures)
+            c.reset();
+    }
+};
+
+/**
+   \brief Counters of the calling thread, registered on its first call and retired when it exits.
+   Defined in SVDStatistics.cpp.
+*/
+ThreadCounters& local();
+}
+
+#ifdef JIXIE_SVD_STATISTICS
+/**
+   \brief Sum of the counters of all threads so far. Defined in SVDStatistics.cpp.
+*/
+Statistics collect();
+
+/**
+   \brief Zero the counters of all threads. Counts of SVDs running at the same time may be lost.
+   Defined in SVDStatistics.cpp.
+*/
+void reset();
+#else
+inline Statistics collect()
+{
+    return Statistics();
+}
+
+inline void reset()
+{
+}
+#endif
+
+/**
+   Hooks of the scalar SVD, empty unless enabled
+*/
+inline void recordIterations(const int count)
+{
+    if (enabled) {
+        INTERNAL::ThreadCounters& c = INTERNAL::local();
+        c.calls.add(1);
+        c.iterations.add(count);
+        c.histogram[std::min(count, histogram_size - 1)].add(1);
+    }
+}
+
+inline void recordBranch(const Branch branch)
+{
+    if (enabled)
+        INTERNAL::local().branches[branch].add(1);
+}
+
+inline void recordSortCase(const SortCase sort_case)
+{
+    if (enabled)
+        INTERNAL::local().sort_cases[sort_case].add(1);
+}
+
+inline void recordStructure(const Structure structure)
+{
+    if (enabled)
+        INTERNAL::local().structures[structure].add(1);
+}
+
+/**
+   Hooks of the batched SVD. Only the lanes in valid are counted, so padding lanes are left out.
+*/
+template <int W, class Vec, class Mask>
+inline void recordIterations(const Vec& count, const Mask& valid)
+{
+    if (enabled) {
+        for (int l = 0; l < W; l++)
+            if (valid[l])
+                recordIterations((int)count[l]);
+    }
+}
+
+template <int W, class Mask>
+inline void recordBranch(const Branch branch, const Mask& lanes)
+{
+    if (enabled) {
+        uint64_t n = 0;
+        for (int l = 0; l < W; l++)
+            n += lanes[l] != 0;
+        INTERNAL::local().branches[branch].add(n);
+    }
+}
+
+template <int W, class Mask>
+inline void recordSortCase(const SortCase sort_case, const Mask& lanes)
+{
+    if (enabled) {
+        uint64_t n = 0;
+        for (int l = 0; l < W; l++)
+            n += lanes[l] != 0;
+        INTERNAL::local().sort_cases[sort_case].add(n);
+    }
+}
+}
+}
+#endif
@@ -0,0 +1,202 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   This file provides a thin wrapper around gcc/clang vector extensions so that
+   the same kernel code can run on 4/8/16 lanes (SSE/AVX2/AVX-512).
+
+   T may be float or double. W is the number of lanes.
+
+   using P = JIXIE::SIMD::Pack<float, 8>;
+   P::Vec a = P::broadcast(1), b = P::load(ptr);
+   P::Mask m = a < b;          // per lane comparison
+   P::Vec c = P::select(m, a, b);
+   if (P::any(m)) { ... }
+   ################################################################################
+*/
+
+#ifndef JIXIE_SIMD_PACK_H
+#define JIXIE_SIMD_PACK_H
+
+#include <immintrin.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace JIXIE {
+namespace SIMD {
+
+/**
+   Number of lanes of the widest vector register enabled at compile time.
+*/
+template <class T>
+struct NativeWidth {
+#if defined(__AVX512F__)
+    static constexpr int value = 64 / sizeof(T);
+#elif defined(__AVX__)
+    static constexpr int value = 32 / sizeof(T);
+#else
+    static constexpr int value = 16 / sizeof(T);
+#endif
+};
+
+namespace INTERNAL {
+template <class T>
+struct MaskScalar;
+template <>
+struct MaskScalar<float> {
+    using type = int32_t;
+};
+template <>
+struct MaskScalar<double> {
+    using type = int64_t;
+};
+
+/**
+   Lane wise square root. The generic version works for any width,
+   the specializations make sure a single instruction is used.
+*/
+template <class T, int W>
+struct Sqrt {
+    template <class Vec>
+    static inline Vec run(Vec x)
+    {
+        for (int i = 0; i < W; i++)
+            x[i] = std::sqrt(x[i]);
+        return x;
+    }
+};
+template <>
+struct Sqrt<float, 4> {
+    template <class Vec>
+    static inline Vec run(Vec x) { return (Vec)_mm_sqrt_ps((__m128)x); }
+};
+template <>
+struct Sqrt<double, 2> {
+    template <class Vec>
+    static inline Vec run(Vec x) { return (Vec)_mm_sqrt_pd((__m128d)x); }
+};
+#if defined(__AVX__)
+template <>
+struct Sqrt<float, 8> {
+    template <class Vec>
+    static inline Vec run(Vec x) { return (Vec)_mm256_sqrt_ps((__m256)x); }
+};
+template <>
+struct Sqrt<double, 4> {
+    template <class Vec>
+    static inline Vec run(Vec x) { return (Vec)_mm256_sqrt_pd((__m256d)x); }
+};
+#endif
+#if defined(__AVX512F__)
+template <>
+struct Sqrt<float, 16> {
+    template <class Vec>
+    static inline Vec run(Vec x) { return (Vec)_mm512_sqrt_ps((__m512)x); }
+};
+template <>
+struct Sqrt<double, 8> {
+    template <class Vec>
+    static inline Vec run(Vec x) { return (Vec)_mm512_sqrt_pd((__m512d)x); }
+};
+#endif
+}
+
+/**
+   W lanes of T. Arithmetic and comparison operators come from the vector
+   extension itself, everything else is a static helper.
+*/
+template <class T, int W = NativeWidth<T>::value>
+struct Pack {
+    using Scalar = T;
+    using MaskScalar = typename INTERNAL::MaskScalar<T>::type;
+    typedef T Vec __attribute__((vector_size(W * sizeof(T))));
+    typedef MaskScalar Mask __attribute__((vector_size(W * sizeof(T))));
+    static constexpr int Width = W;
+
+    static inline Vec broadcast(const T x)
+    {
+        Vec v;
+        for (int i = 0; i < W; i++)
+            v[i] = x;
+        return v;
+    }
+
+    static inline Vec load(const T* p)
+    {
+        Vec v;
+        std::memcpy(&v, p, sizeof(Vec));
+        return v;
+    }
+
+    static inline void store(T* p, const Vec v)
+    {
+        std::memcpy(p, &v, sizeof(Vec));
+    }
+
+    static inline Vec select(const Mask m, const Vec a, const Vec b)
+    {
+        return m ? a : b;
+    }
+
+    static inline Vec sqrt(const Vec x)
+    {
+        return INTERNAL::Sqrt<T, W>::run(x);
+    }
+
+    static inline Vec abs(const Vec x)
+    {
+        return (Vec)((Mask)x & ~signMask());
+    }
+
+    /**
+       Magnitude of x with the sign of y, same as std::copysign
+    */
+    static inline Vec copysign(const Vec x, const Vec y)
+    {
+        return (Vec)(((Mask)x & ~signMask()) | ((Mask)y & signMask()));
+    }
+
+    static inline bool any(const Mask m)
+    {
+        MaskScalar r = 0;
+        for (int i = 0; i < W; i++)
+            r |= m[i];
+        return r != 0;
+    }
+
+private:
+    static inline Mask signMask()
+    {
+        return (Mask)broadcast(T(-0.0));
+    }
+};
+}
+}
+#endif
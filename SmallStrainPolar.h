@@ -0,0 +1,275 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   This file implements 3D polar decompositions and SVDs of small strain deformation
+   gradients F = I + H, |H| << 1, in closed form.
+
+   With w the axial vector of the skew part of H and E its symmetric part, the rotation
+   vector of the polar factor R is, to second order in H,
+      omega = w - (tr(E) w - E w) / 2
+   R is built from omega through the quaternion (1, omega (1 + |omega|^2 / 12) / 2), so it is
+   a rotation to rounding whatever H is, and its angle has no error of its own up to third order.
+   The error of R is then c |H|^3 in the Frobenius norm of H, c about 0.12 on random H.
+
+   The a priori check takes c = 1 / 4 and accepts F if c |H|^3 <= tol / 2, that is
+   |H|^6 <= 4 tol^2, the other half of tol being left to rounding. The result is certified
+   by the residual r = |axial(skew(R'F))|: F - R S = R skew(R'F) with S the symmetric part
+   of R'F, so every entry of the reconstruction error is at most r, and R is about r / (1 - |H|)
+   away from the polar factor. r comes almost free with S. If either check fails, the result
+   comes from the SVD based polarDecomposition.
+
+   tol defaults to 8 epsilon, where the check accepts |H| up to about 1e-2 in float and
+   1.5e-5 in double. A larger tol trades accuracy for a wider range in double.
+
+   Eigen::Matrix<T, 3, 3> F, R, S, U, V;
+   Eigen::Matrix<T, 3, 1> sigma;
+   int path = JIXIE::smallStrainPolarDecomposition(F, R, S); // 0, or -1 if the SVD was used
+   JIXIE::singularValueDecomposition<JIXIE::SmallStrain>(F, U, sigma, V);
+   // U = R V_S from the Jacobi eigenvalue iteration on S = V_S diag(sigma) V_S'
+
+   JIXIE::MatrixStreams<T, 3, 3> F(n), R(n);
+   JIXIE::MatrixStreams<T, 6, 1> S(n); // entries 00, 11, 22, 12, 02, 01 of S, like SymmetricMatrix3
+   JIXIE::batchSmallStrainPolarDecomposition(n, F.streams(), R.streams(), S.streams());
+   ################################################################################
+*/
+
+#ifndef JIXIE_SMALL_STRAIN_POLAR_H
+#define JIXIE_SMALL_STRAIN_POLAR_H
+
+#include "ImplicitQRSVD.h"
+#include "BatchSVD.h"
+
+namespace JIXIE {
+
+namespace SMALL_STRAIN {
+
+template <class T>
+inline T tolerance()
+{
+    return 8 * std::numeric_limits<T>::epsilon();
+}
+
+/**
+   \brief |F - I|^2 in the Frobenius norm, for the a priori check
+*/
+template <class Matrix>
+inline auto squaredStrain(const Matrix& F) -> typename std::decay<decltype(F(0, 0))>::type
+{
+    auto d = F(0, 0) - 1;
+    auto s = d * d;
+    for (int k = 1; k < 9; k++) {
+        d = k % 4 == 0 ? F(k % 3, k / 3) - 1 : F(k % 3, k / 3);
+        s += d * d;
+    }
+    return s;
+}
+
+/**
+   \brief R from the second order rotation vector of F = I + H, see the top of the file
+*/
+template <class Matrix>
+inline void rotation(const Matrix& F, Matrix& R)
+{
+    typedef typename std::decay<decltype(F(0, 0))>::type Scalar;
+    Scalar h[3][3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            h[i][j] = i == j ? F(i, j) - 1 : F(i, j);
+
+    Scalar w[3] = { (h[2][1] - h[1][2]) * 0.5f, (h[0][2] - h[2][0]) * 0.5f, (h[1][0] - h[0][1]) * 0.5f };
+    Scalar trace = h[0][0] + h[1][1] + h[2][2];
+    Scalar omega[3];
+    for (int i = 0; i < 3; i++) {
+        // E w with E the symmetric part of H
+        Scalar Ew = h[i][i] * w[i];
+        for (int j = 0; j < 3; j++)
+            if (j != i)
+                Ew += (h[i][j] + h[j][i]) * 0.5f * w[j];
+        omega[i] = w[i] - (trace * w[i] - Ew) * 0.5f;
+    }
+
+    // quaternion (1, x, y, z), half the rotation vector times tan(|omega| / 2) / (|omega| / 2)
+    Scalar factor = (omega[0] * omega[0] + omega[1] * omega[1] + omega[2] * omega[2]) / 12 + 1;
+    Scalar x = omega[0] * factor * 0.5f, y = omega[1] * factor * 0.5f, z = omega[2] * factor * 0.5f;
+    Scalar s = 2 / (x * x + y * y + z * z + 1);
+    R(0, 0) = 1 - s * (y * y + z * z);
+    R(1, 1) = 1 - s * (x * x + z * z);
+    R(2, 2) = 1 - s * (x * x + y * y);
+    R(0, 1) = s * (x * y - z);
+    R(1, 0) = s * (x * y + z);
+    R(0, 2) = s * (x * z + y);
+    R(2, 0) = s * (x * z - y);
+    R(1, 2) = s * (y * z - x);
+    R(2, 1) = s * (y * z + x);
+}
+
+/**
+   \brief P = R'F
+   \return The squared certificate r^2 = |axial(skew(P))|^2, see the top of the file.
+*/
+template <class Matrix>
+inline auto product(const Matrix& R, const Matrix& F, Matrix& P) -> typename std::decay<decltype(F(0, 0))>::type
+{
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            P(i, j) = R(0, i) * F(0, j) + R(1, i) * F(1, j) + R(2, i) * F(2, j);
+    auto a = (P(2, 1) - P(1, 2)) * 0.5f, b = (P(0, 2) - P(2, 0)) * 0.5f, c = (P(1, 0) - P(0, 1)) * 0.5f;
+    return a * a + b * b + c * c;
+}
+}
+
+/**
+   \brief 3X3 polar decomposition A = R S for A close to the identity, see the top of the file.
+   \param[in] A matrix.
+   \param[out] R Robustly a rotation matrix.
+   \param[out] S Symmetric. Only the smallest eigenvalue can be negative, and only if det(A) < 0.
+   \param[in] tol Bound on the entries of A - R S asked for, and so on |R - R_polar| up to a factor 1 / (1 - |A - I|).
+   \return 0, or -1 if the result comes from the SVD.
+*/
+template <class T>
+inline int smallStrainPolarDecomposition(const Eigen::Matrix<T, 3, 3>& A,
+    Eigen::Matrix<T, 3, 3>& R,
+    Eigen::Matrix<T, 3, 3>& S,
+    const T tol = SMALL_STRAIN::tolerance<T>())
+{
+    // both checks are written to fail for NaN
+    T h2 = SMALL_STRAIN::squaredStrain(A);
+    if (h2 * h2 * h2 <= 4 * tol * tol) {
+        SMALL_STRAIN::rotation(A, R);
+        Eigen::Matrix<T, 3, 3> P;
+        if (SMALL_STRAIN::product(R, A, P) <= tol * tol) {
+            S = (T)0.5 * (P + P.transpose());
+            return 0;
+        }
+    }
+    polarDecomposition(A, R, S);
+    return -1;
+}
+
+/**
+   \brief 3X3 SVD of A close to the identity, same conventions as singularValueDecomposition.
+   \tparam Options Which of U and V to compute, see SVDOptions. A factor that is not computed is left untouched.
+   \return Number of Jacobi sweeps, or of QR iterations if the result comes from the implicit QR SVD.
+
+   A = R S from smallStrainPolarDecomposition, then S = V diag(sigma) V' by symmetricSingularValueDecomposition,
+   whose sortDiagonal makes U = R V a rotation with the signs of the eigenvalues moved in. Since S is about
+   I + sym(A - I), the sweeps start close to diagonal.
+*/
+template <int Options = ComputeUV, class T>
+inline int smallStrainSingularValueDecomposition(const Eigen::Matrix<T, 3, 3>& A,
+    Eigen::Matrix<T, 3, 3>& U,
+    Eigen::Matrix<T, 3, 1>& sigma,
+    Eigen::Matrix<T, 3, 3>& V,
+    const T tol = SMALL_STRAIN::tolerance<T>())
+{
+    typedef Eigen::Matrix<T, 3, 3> Matrix;
+    T h2 = SMALL_STRAIN::squaredStrain(A);
+    if (h2 * h2 * h2 <= 4 * tol * tol) {
+        Matrix R, P;
+        SMALL_STRAIN::rotation(A, R);
+        if (SMALL_STRAIN::product(R, A, P) <= tol * tol) {
+            Matrix U_S, V_S;
+            int sweeps = symmetricSingularValueDecomposition(Matrix((T)0.5 * (P + P.transpose())), U_S, sigma, V_S);
+            if (Options & ComputeU)
+                U = R * U_S;
+            if (Options & ComputeV)
+                V = V_S;
+            return sweeps;
+        }
+    }
+    return singularValueDecomposition<Options>(A, U, sigma, V);
+}
+
+/**
+   Engine policy for singularValueDecomposition<Engine>: smallStrainSingularValueDecomposition, closed form
+   for A close to the identity with the implicit QR SVD as fallback.
+*/
+struct SmallStrain {
+    template <int Options, class T>
+    static inline int run(const Eigen::Matrix<T, 3, 3>& A,
+        Eigen::Matrix<T, 3, 3>& U,
+        Eigen::Matrix<T, 3, 1>& sigma,
+        Eigen::Matrix<T, 3, 3>& V)
+    {
+        return smallStrainSingularValueDecomposition<Options>(A, U, sigma, V);
+    }
+};
+
+namespace SIMD {
+
+/**
+   \brief smallStrainPolarDecomposition on all the lanes of A. S gets the entries 00, 11, 22, 12, 02, 01.
+   Returns a mask of the lanes left to the SVD, whose R and S are garbage.
+*/
+template <class P>
+inline typename P::Mask smallStrainPolarDecomposition(const Matrix3<P>& A, Matrix3<P>& R, typename P::Vec S[6], const typename P::Scalar tol)
+{
+    using T = typename P::Scalar;
+    using Vec = typename P::Vec;
+    Matrix3<P> X;
+    Vec h2 = SMALL_STRAIN::squaredStrain(A);
+    SMALL_STRAIN::rotation(A, R);
+    Vec r2 = SMALL_STRAIN::product(R, A, X);
+    for (int k = 0; k < 6; k++) {
+        const int i = SymmetricMatrix3<T>::row(k), j = SymmetricMatrix3<T>::col(k);
+        S[k] = (X(i, j) + X(j, i)) * 0.5f;
+    }
+    // negated, so that NaN lanes fail
+    return ~((h2 * h2 * h2 <= P::broadcast(4 * tol * tol)) & (r2 <= P::broadcast(tol * tol)));
+}
+}
+
+/**
+   \brief Batched smallStrainPolarDecomposition on structure-of-arrays data.
+   \param[in] n Number of matrices.
+   \param[in] A 9 input streams in column major order.
+   \param[out] R 9 output streams. Every R is a rotation matrix.
+   \param[out] S 6 output streams with the entries 00, 11, 22, 12, 02, 01 of S, the order of SymmetricMatrix3.
+   \param[out] count Optional, 0 per matrix, -1 if the result comes from the SVD.
+
+   The lanes that need the SVD go through the scalar polarDecomposition after their pack.
+   W is the number of SIMD lanes and defaults to the widest enabled register.
+*/
+template <class T, int W = SIMD::NativeWidth<T>::value>
+inline void batchSmallStrainPolarDecomposition(const size_t n,
+    const T* const A[9],
+    T* const R[9],
+    T* const S[6],
+    int* count = nullptr,
+    const T tol = SMALL_STRAIN::tolerance<T>())
+{
+    using P = SIMD::Pack<T, W>;
+    SIMD::batchPolarDecomposition<P>(n, A, R, S, count, [tol](const SIMD::Matrix3<P>& a, SIMD::Matrix3<P>& r, typename P::Vec s[6]) {
+        // 0 iterations, -1 on the lanes left to the SVD
+        return P::select(SIMD::smallStrainPolarDecomposition(a, r, s, tol), P::broadcast(-1), P::broadcast(0));
+    });
+}
+}
+#endif
@@ -0,0 +1,1250 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   This file provides the test case families of the benchmarks and the accuracy
+   metrics they report.
+
+   std::vector<Eigen::Matrix<T, 3, 3> > tests;
+   JIXIE::addCases(tests, "identity_perturbation:256eps", JIXIE::CaseParameters());
+   // or without storing them, any range from any thread
+   auto cases = JIXIE::makeCaseGenerator<T>("integer", parameters);
+   cases->fill(first, n, matrices); // also get(i), size() and fillStreams(first, n, A_streams)
+   JIXIE::IntegerOrbits<T> orbits(range); // "integer_orbits": one case per symmetry orbit of "integer"
+   orbits.image(orbits.get(i), g); // any of its 2304 images, also orbitSize(i) and gridIndex(i)
+   JIXIE::SpectrumCases<T> hard(n, JIXIE::NearInversionSpectrum); // U diag(sigma) V' with adversarial sigma
+   JIXIE::AccuracyErrors<T> errors;
+   errors.addSVD(A, U, sigma, V); // or addPolar(F, R, S)
+   errors.max(JIXIE::AccuracyErrors<T>::UUt); // also average, standardDeviation, count
+   total += errors; // merges the accumulators of separate runs or threads
+   errors.maxUlps(JIXIE::AccuracyErrors<T>::Reconstruction); // error / (epsilon * |A|)
+   errors.metric(JIXIE::AccuracyErrors<T>::Reconstruction).worst_input; // also histogram, worst_index
+
+   // SIMD and threaded checking of batched results, see BatchSVD.h for the streams
+   JIXIE::parallelCheckSVD(pool, n, A.streams(), U.streams(), sigma.streams(), V.streams());
+   ################################################################################
+*/
+
+#ifndef JIXIE_TEST_CASES_H
+#define JIXIE_TEST_CASES_H
+
+#include "Tools.h"
+#include "Benchmark.h"
+#include "SimdPack.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace JIXIE {
+
+/**
+   Streams of the PhiloxRandomNumber generator (seed 123) used by the case families
+*/
+enum CaseStream {
+    RandomCaseStream,
+    IdentityPerturbationStream,
+    IntegerPerturbationStream,
+    SpectrumStream, // plus the SpectrumFamily
+    StructureStream = SpectrumStream + 8 // plus the StructureFamily
+};
+
+/**
+   \brief A case family that makes its matrices on demand instead of storing them.
+   Case i is a fixed function of i, so any range can be generated on its own, by any
+   thread, in constant memory.
+*/
+template <class T>
+class CaseGenerator {
+public:
+    typedef Eigen::Matrix<T, 3, 3> Matrix;
+
+    virtual ~CaseGenerator() {}
+
+    virtual size_t size() const = 0;
+
+    virtual Matrix get(const size_t i) const = 0;
+
+    /**
+       out[j] = get(first + j) for j < n
+    */
+    virtual void fill(const size_t first, const size_t n, Matrix* out) const
+    {
+        for (size_t j = 0; j < n; j++)
+            out[j] = get(first + j);
+    }
+
+    /**
+       Same as fill into the structure-of-arrays streams of BatchSVD.h: entry k of case first + j goes to A[k][j]
+    */
+    void fillStreams(const size_t first, const size_t n, T* const A[9]) const
+    {
+        const size_t block = 64;
+        Matrix M[block];
+        for (size_t begin = 0; begin < n; begin += block) {
+            size_t m = std::min(block, n - begin);
+            fill(first + begin, m, M);
+            for (size_t j = 0; j < m; j++)
+                for (int k = 0; k < 9; k++)
+                    A[k][begin + j] = M[j](k);
+        }
+    }
+};
+
+/**
+   n matrices base + Z where the entries of Z are uniform in [a, b).
+   Case i takes numbers 9 i to 9 i + 8 of its Philox stream.
+*/
+template <class T>
+class UniformCases : public CaseGenerator<T> {
+public:
+    typedef typename CaseGenerator<T>::Matrix Matrix;
+
+    UniformCases(const size_t n, const T a, const T b, const CaseStream stream, const Matrix& base = Matrix::Zero())
+        : n(n)
+        , a(a)
+        , b(b)
+        , base(base)
+        , random(123, stream)
+    {
+    }
+
+    size_t size() const override
+    {
+        return n;
+    }
+
+    Matrix get(const size_t i) const override
+    {
+        Matrix Z;
+        for (int k = 0; k < 9; k++)
+            Z(k) = random.uniform(9 * i + k, a, b);
+        return base + Z;
+    }
+
+    void fill(const size_t first, const size_t n, Matrix* out) const override
+    {
+        static_assert(sizeof(Matrix) == 9 * sizeof(T), "matrices must be packed to be filled as one array");
+        random.fill(out[0].data(), 9 * n, 9 * first, a, b);
+        if (base != Matrix::Zero())
+            for (size_t j = 0; j < n; j++)
+                out[j] += base;
+    }
+
+private:
+    size_t n;
+    T a, b;
+    Matrix base;
+    PhiloxRandomNumber<T> random;
+};
+
+/**
+   Every matrix with integer entries in [-range, range], (2 range + 1)^9 of them.
+   Case i has entry k equal to digit k of i in base 2 range + 1, minus range, so
+   entry 0 runs fastest.
+*/
+template <class T>
+class IntegerCases : public CaseGenerator<T> {
+public:
+    typedef typename CaseGenerator<T>::Matrix Matrix;
+
+    IntegerCases(const int range)
+        : range(range)
+        , count(1)
+    {
+        for (int k = 0; k < 9; k++)
+            count *= 2 * range + 1;
+    }
+
+    size_t size() const override
+    {
+        return count;
+    }
+
+    Matrix get(size_t i) const override
+    {
+        Matrix Z;
+        for (int k = 0; k < 9; k++, i /= 2 * range + 1)
+            Z(k) = (T)((int)(i % (2 * range + 1)) - range);
+        return Z;
+    }
+
+    /**
+       Decodes the first case and counts up from there
+    */
+    void fill(const size_t first, const size_t n, Matrix* out) const override
+    {
+        Matrix Z = get(first);
+        for (size_t j = 0; j < n; j++) {
+            out[j] = Z;
+            next(Z);
+        }
+    }
+
+    /**
+       The case after Z, wrapping around after the last one
+    */
+    void next(Matrix& Z) const
+    {
+        for (int k = 0; k < 9; k++) {
+            if (Z(k) < range) {
+                Z(k)++;
+                return;
+            }
+            Z(k) = (T)-range;
+        }
+    }
+
+private:
+    int range;
+    size_t count;
+};
+
+/**
+   \brief Uniformly random rotation from three numbers uniform in [0, 1), by Shoemake's method
+*/
+inline Eigen::Matrix3d uniformRotation(const double u[3])
+{
+    const double two_pi = 6.283185307179586;
+    double a = std::sqrt(1 - u[0]), b = std::sqrt(u[0]);
+    double w = b * std::cos(two_pi * u[2]), x = a * std::sin(two_pi * u[1]), y = a * std::cos(two_pi * u[1]), z = b * std::sin(two_pi * u[2]);
+    Eigen::Matrix3d R;
+    R << 1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y),
+        2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x),
+        2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y);
+    return R;
+}
+
+/**
+   Singular value spectra that make the implicit QR iteration work hardest, see SpectrumCases
+*/
+enum SpectrumFamily {
+    ClusteredSpectrum, // two or three singular values equal up to a relative 2^-k, k up to the mantissa bits
+    IllConditionedSpectrum, // condition number up to 1 / epsilon, the middle one log-uniform in between
+    NearRankOneSpectrum, // sigma_2, sigma_3 between epsilon^1.5 and epsilon^0.5 times sigma_1
+    NearInversionSpectrum, // sigma_3 of either sign with a magnitude down to epsilon, so det A crosses 0
+    ScaledSpectrum, // well conditioned, scaled by 2^k, |k| up to a quarter of the exponent range so sigma^4 still fits
+    SpectrumFamilyCount
+};
+
+/**
+   \brief n matrices U diag(sigma) V' with uniformly random rotations U and V and the spectrum
+   of a SpectrumFamily. Case i takes numbers 10 i to 10 i + 9 of its Philox stream, the
+   rotations come from the first 6 by Shoemake's method. The product is formed in double
+   and rounded to T, so sigma holds up to the rounding of A.
+*/
+template <class T>
+class SpectrumCases : public CaseGenerator<T> {
+public:
+    typedef typename CaseGenerator<T>::Matrix Matrix;
+
+    SpectrumCases(const size_t n, const SpectrumFamily family)
+        : n(n)
+        , family(family)
+        , random(123, SpectrumStream + family)
+    {
+    }
+
+    size_t size() const override
+    {
+        return n;
+    }
+
+    Matrix get(const size_t i) const override
+    {
+        double u[10];
+        for (int k = 0; k < 10; k++)
+            u[k] = random.uniform(10 * i + k, 0, 1);
+        return make(u);
+    }
+
+    void fill(const size_t first, const size_t n, Matrix* out) const override
+    {
+        const size_t block = 64;
+        double u[10 * block];
+        for (size_t begin = 0; begin < n; begin += block) {
+            size_t m = std::min(block, n - begin);
+            random.fill(u, 10 * m, 10 * (first + begin), 0, 1);
+            for (size_t j = 0; j < m; j++)
+                out[begin + j] = make(u + 10 * j);
+        }
+    }
+
+    static const char* name(const SpectrumFamily family)
+    {
+        static const char* names[SpectrumFamilyCount] = { "clustered", "ill_conditioned", "near_rank1", "near_inversion", "scaled" };
+        return names[family];
+    }
+
+private:
+    size_t n;
+    SpectrumFamily family;
+    PhiloxRandomNumber<double> random;
+
+    Matrix make(const double u[10]) const
+    {
+        const double digits = std::numeric_limits<T>::digits;
+        Eigen::Vector3d sigma;
+        switch (family) {
+        case ClusteredSpectrum: {
+            double delta = std::exp2(-u[6] * digits);
+            sigma << 1, 1 + delta * u[7], u[9] < 0.5 ? 1 + delta * u[8] : u[8];
+            break;
+        }
+        case IllConditionedSpectrum: {
+            double log2_condition = u[6] * digits;
+            sigma << 1, std::exp2(-u[7] * log2_condition), std::exp2(-log2_condition);
+            break;
+        }
+        case NearRankOneSpectrum: {
+            double delta = std::exp2(-(0.5 + u[6]) * digits);
+            sigma << 1, delta * u[7], delta * u[8];
+            break;
+        }
+        case NearInversionSpectrum: {
+            double delta = std::exp2(-u[6] * digits);
+            sigma << 0.5 + u[7], 0.5 + u[8], u[9] < 0.5 ? -delta : delta;
+            break;
+        }
+        default: {
+            double range = std::numeric_limits<T>::max_exponent / 4 - 2;
+            sigma << 0.5 + u[7], 0.5 + u[8], 0.5 + u[9];
+            sigma *= std::exp2(std::round((2 * u[6] - 1) * range));
+            break;
+        }
+        }
+        return (uniformRotation(u) * sigma.asDiagonal() * uniformRotation(u + 3).transpose()).template cast<T>();
+    }
+};
+
+/**
+   Inputs with the structures the Structured engine has fast paths for, see StructureCases
+*/
+enum StructureFamily {
+    DiagonalInput, // axis aligned stretch
+    SymmetricInput, // e.g. S of a previous polar decomposition
+    BidiagonalInput, // upper bidiagonal
+    RotationInput, // rigid motion, a uniformly random rotation rounded to T
+    MixedStructureInput, // each of the above and a general matrix, one fifth each
+    StructureFamilyCount
+};
+
+/**
+   \brief n matrices of a StructureFamily with entries uniform in [-range, range). Case i takes
+   numbers 10 i to 10 i + 9 of its Philox stream, the last one picks the structure of a mixed case.
+*/
+template <class T>
+class StructureCases : public CaseGenerator<T> {
+public:
+    typedef typename CaseGenerator<T>::Matrix Matrix;
+
+    StructureCases(const size_t n, const T range, const StructureFamily family)
+        : n(n)
+        , range(range)
+        , family(family)
+        , random(123, StructureStream + family)
+    {
+    }
+
+    size_t size() const override
+    {
+        return n;
+    }
+
+    Matrix get(const size_t i) const override
+    {
+        double u[10];
+        for (int k = 0; k < 10; k++)
+            u[k] = random.uniform(10 * i + k, 0, 1);
+        return make(u);
+    }
+
+    void fill(const size_t first, const size_t n, Matrix* out) const override
+    {
+        const size_t block = 64;
+        double u[10 * block];
+        for (size_t begin = 0; begin < n; begin += block) {
+            size_t m = std::min(block, n - begin);
+            random.fill(u, 10 * m, 10 * (first + begin), 0, 1);
+            for (size_t j = 0; j < m; j++)
+                out[begin + j] = make(u + 10 * j);
+        }
+    }
+
+    static const char* name(const StructureFamily family)
+    {
+        static const char* names[StructureFamilyCount] = { "diagonal", "symmetric", "bidiagonal", "rotation", "mixed_structure" };
+        return names[family];
+    }
+
+private:
+    size_t n;
+    T range;
+    StructureFamily family;
+    PhiloxRandomNumber<double> random;
+
+    Matrix make(const double u[10]) const
+    {
+        StructureFamily structure = family == MixedStructureInput ? (StructureFamily)(int)(5 * u[9]) : family;
+        auto entry = [&](int k) { return (T)(range * (2 * u[k] - 1)); };
+        Matrix A = Matrix::Zero();
+        switch (structure) {
+        case DiagonalInput:
+            A.diagonal() << entry(0), entry(1), entry(2);
+            break;
+        case SymmetricInput:
+            A << entry(0), entry(3), entry(4),
+                entry(3), entry(1), entry(5),
+                entry(4), entry(5), entry(2);
+            break;
+        case BidiagonalInput:
+            A << entry(0), entry(3), 0,
+                0, entry(1), entry(4),
+                0, 0, entry(2);
+            break;
+        case RotationInput:
+            A = uniformRotation(u).template cast<T>();
+            break;
+        default:
+            for (int k = 0; k < 9; k++)
+                A(k) = entry(k);
+        }
+        return A;
+    }
+};
+
+/**
+   \brief One representative of every orbit of the integer cases under the symmetries of the SVD.
+
+   Permuting or negating rows or columns and transposing change the SVD only by the
+   same permutations and signs, so one matrix of each orbit of that group is enough
+   for an exhaustive sweep. The group has 2 * 6 * 6 * 2^5 = 2304 elements: negating
+   every row and every column at once is the identity, so the sign of column 0 is
+   kept. The representative of an orbit is its member with the lowest integer case
+   index. The orbits are found by a sieve: the cases are scanned in order, and every
+   case not yet marked starts an orbit, all of whose members get marked. This needs
+   one bit per integer case, 48 MB at range 4, and about 2304 * 9 operations per
+   orbit.
+*/
+template <class T>
+class IntegerOrbits : public CaseGenerator<T> {
+public:
+    typedef typename CaseGenerator<T>::Matrix Matrix;
+    static constexpr int group_size = 2304;
+
+    IntegerOrbits(const int range)
+        : grid(range)
+    {
+        for (int g = 0; g < group_size; g++)
+            element(g, target[g], negate[g]);
+        const int base = 2 * range + 1;
+        size_t power[9];
+        power[0] = 1;
+        for (int k = 1; k < 9; k++)
+            power[k] = power[k - 1] * base;
+        const size_t n = grid.size();
+        std::vector<uint64_t> marked((n + 63) / 64, 0);
+        for (size_t word = 0; word < marked.size(); word++) {
+            while (~marked[word]) {
+                size_t i = word * 64 + __builtin_ctzll(~marked[word]);
+                if (i >= n)
+                    break;
+                int digit[9];
+                size_t rest = i;
+                for (int k = 0; k < 9; k++, rest /= base)
+                    digit[k] = (int)(rest % base);
+                unsigned members = 0;
+                for (int g = 0; g < group_size; g++) {
+                    size_t j = 0;
+                    for (int k = 0; k < 9; k++)
+                        j += (size_t)(negate[g][k] ? 2 * range - digit[k] : digit[k]) * power[target[g][k]];
+                    uint64_t bit = (uint64_t)1 << (j % 64);
+                    if (!(marked[j / 64] & bit)) {
+                        marked[j / 64] |= bit;
+                        members++;
+                    }
+                }
+                representatives.push_back(i);
+                orbit_sizes.push_back((uint16_t)members);
+            }
+        }
+    }
+
+    size_t size() const override
+    {
+        return representatives.size();
+    }
+
+    Matrix get(const size_t i) const override
+    {
+        return grid.get(representatives[i]);
+    }
+
+    /**
+       Number of integer cases, i.e. the total size of the orbits
+    */
+    size_t gridSize() const
+    {
+        return grid.size();
+    }
+
+    /**
+       Integer case index of representative i
+    */
+    size_t gridIndex(const size_t i) const
+    {
+        return representatives[i];
+    }
+
+    /**
+       Number of distinct matrices in the orbit of representative i
+    */
+    size_t orbitSize(const size_t i) const
+    {
+        return orbit_sizes[i];
+    }
+
+    /**
+       A transformed by group element g in [0, group_size)
+    */
+    Matrix image(const Matrix& A, const int g) const
+    {
+        Matrix B;
+        for (int k = 0; k < 9; k++)
+            B(target[g][k]) = negate[g][k] ? -A(k) : A(k);
+        return B;
+    }
+
+private:
+    IntegerCases<T> grid;
+    std::vector<size_t> representatives;
+    std::vector<uint16_t> orbit_sizes;
+    int target[group_size][9]; // where entry k of A goes
+    bool negate[group_size][9];
+
+    /**
+       g = ((((t * 6 + p) * 6 + q) * 8 + row signs) * 4 + column signs): B(i, j) = s_i c_j A'(p(i), q(j)),
+       with A' = A or its transpose and the sign of column 0 kept.
+    */
+    static void element(int g, int target[9], bool negate[9])
+    {
+        static const int permutations[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+        int column_signs = g % 4;
+        g /= 4;
+        int row_signs = g % 8;
+        g /= 8;
+        const int* q = permutations[g % 6];
+        g /= 6;
+        const int* p = permutations[g % 6];
+        bool transpose = g / 6;
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++) {
+                int source = transpose ? q[j] + 3 * p[i] : p[i] + 3 * q[j];
+                target[source] = i + 3 * j;
+                negate[source] = (((row_signs >> i) & 1) ^ ((column_signs << 1 >> j) & 1)) != 0;
+            }
+    }
+};
+
+/**
+   count perturbations of every integer case, the perturbations uniform in [-perturb, perturb).
+   Case i is integer case i / count plus numbers 9 i to 9 i + 8 of its Philox stream.
+*/
+template <class T>
+class IntegerPerturbationCases : public CaseGenerator<T> {
+public:
+    typedef typename CaseGenerator<T>::Matrix Matrix;
+
+    IntegerPerturbationCases(const int range, const int count, const T perturb)
+        : integers(range)
+        , count(count)
+        , perturbations(integers.size() * count, -perturb, perturb, IntegerPerturbationStream)
+    {
+    }
+
+    size_t size() const override
+    {
+        return perturbations.size();
+    }
+
+    Matrix get(const size_t i) const override
+    {
+        return integers.get(i / count) + perturbations.get(i);
+    }
+
+    void fill(const size_t first, const size_t n, Matrix* out) const override
+    {
+        perturbations.fill(first, n, out);
+        Matrix Z = integers.get(first / count);
+        size_t repeat = first % count;
+        for (size_t j = 0; j < n; j++) {
+            out[j] += Z;
+            if (++repeat == (size_t)count) {
+                repeat = 0;
+                integers.next(Z);
+            }
+        }
+    }
+
+private:
+    IntegerCases<T> integers;
+    int count;
+    UniformCases<T> perturbations;
+};
+
+/**
+   \brief Appends every case of the generator, generated in parallel.
+*/
+template <class T>
+void addGeneratedCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const CaseGenerator<T>& generator)
+{
+    size_t old_count = tests.size();
+    tests.resize(old_count + generator.size());
+    Eigen::Matrix<T, 3, 3>* cases = tests.data() + old_count;
+    ThreadPool pool(0, false);
+    pool.parallelFor(generator.size(), 16384, [&](size_t begin, size_t end, int) {
+        generator.fill(begin, end - begin, cases + begin);
+    });
+}
+
+template <class T>
+void addRandomCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const T random_range, const int N)
+{
+    int old_count = tests.size();
+    std::cout << std::setprecision(10) << "Adding random test cases with range " << -random_range << " to " << random_range << std::endl;
+    addGeneratedCases(tests, UniformCases<T>(N, -random_range, random_range, RandomCaseStream));
+    std::cout << std::setprecision(10) << tests.size() - old_count << " cases added." << std::endl;
+    std::cout << std::setprecision(10) << "Total test cases: " << tests.size() << std::endl;
+}
+
+template <class T>
+void addIntegerCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const int int_range)
+{
+    int old_count = tests.size();
+    std::cout << std::setprecision(10) << "Adding integer test cases with range " << -int_range << " to " << int_range << std::endl;
+    addGeneratedCases(tests, IntegerCases<T>(int_range));
+    std::cout << std::setprecision(10) << tests.size() - old_count << " cases added." << std::endl;
+    std::cout << std::setprecision(10) << "Total test cases: " << tests.size() << std::endl;
+}
+
+template <class T>
+void addIntegerOrbitCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const int int_range)
+{
+    int old_count = tests.size();
+    std::cout << std::setprecision(10) << "Adding one integer test case per symmetry orbit with range " << -int_range << " to " << int_range << std::endl;
+    addGeneratedCases(tests, IntegerOrbits<T>(int_range));
+    std::cout << std::setprecision(10) << tests.size() - old_count << " cases added." << std::endl;
+    std::cout << std::setprecision(10) << "Total test cases: " << tests.size() << std::endl;
+}
+
+template <class T>
+void addSpectrumCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const int N, const SpectrumFamily family)
+{
+    int old_count = tests.size();
+    std::cout << std::setprecision(10) << "Adding " << SpectrumCases<T>::name(family) << " U diag(sigma) V' test cases" << std::endl;
+    addGeneratedCases(tests, SpectrumCases<T>(N, family));
+    std::cout << std::setprecision(10) << tests.size() - old_count << " cases added." << std::endl;
+    std::cout << std::setprecision(10) << "Total test cases: " << tests.size() << std::endl;
+}
+
+template <class T>
+void addStructureCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const int N, const T range, const StructureFamily family)
+{
+    int old_count = tests.size();
+    std::cout << std::setprecision(10) << "Adding " << StructureCases<T>::name(family) << " test cases with range " << -range << " to " << range << std::endl;
+    addGeneratedCases(tests, StructureCases<T>(N, range, family));
+    std::cout << std::setprecision(10) << tests.size() - old_count << " cases added." << std::endl;
+    std::cout << std::setprecision(10) << "Total test cases: " << tests.size() << std::endl;
+}
+
+template <class T>
+void addPerturbationFromIdentityCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const int num_perturbations, const T perturb)
+{
+    int old_count = tests.size();
+    std::cout << std::setprecision(10) << "Adding perturbed identity test cases with perturbation " << perturb << std::endl;
+    addGeneratedCases(tests, UniformCases<T>(num_perturbations, -perturb, perturb, IdentityPerturbationStream, Eigen::Matrix<T, 3, 3>::Identity()));
+    std::cout << std::setprecision(10) << tests.size() - old_count << " cases added." << std::endl;
+    std::cout << std::setprecision(10) << "Total test cases: " << tests.size() << std::endl;
+}
+
+template <class T>
+void addPerturbationCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const int int_range, const int num_perturbations, const T perturb)
+{
+    int old_count = tests.size();
+    std::cout << std::setprecision(10) << "Adding perturbed integer test cases with perturbation " << perturb << " and range " << -int_range << " to " << int_range << std::endl;
+    addGeneratedCases(tests, IntegerPerturbationCases<T>(int_range, num_perturbations, perturb));
+    std::cout << std::setprecision(10) << tests.size() - old_count << " cases added." << std::endl;
+    std::cout << std::setprecision(10) << "Total test cases: " << tests.size() << std::endl;
+}
+
+/**
+   Parameters of the case families, see addCases
+*/
+struct CaseParameters {
+    int random_range;
+    int random_count;
+    int integer_range; // used by integer, integer_orbits and integer_perturbation
+    int perturbation_count;
+    int identity_count;
+    int spectrum_count; // used by the SpectrumFamily families
+    int structure_count; // used by the StructureFamily families, with the random_range
+
+    CaseParameters(const JIXIE::BENCHMARK::Options& options = JIXIE::BENCHMARK::Options())
+        : random_range((int)options.getInt("random_range", 3))
+        , random_count((int)options.getInt("random_count", 1024 * 1024))
+        , integer_range((int)options.getInt("integer_range", 2))
+        , perturbation_count((int)options.getInt("perturbation_count", 4))
+        , identity_count((int)options.getInt("identity_count", 1024 * 1024))
+        , spectrum_count((int)options.getInt("spectrum_count", 1024 * 1024))
+        , structure_count((int)options.getInt("structure_count", 1024 * 1024))
+    {
+    }
+};
+
+/**
+   The SpectrumFamily of a case family name, SpectrumFamilyCount if there is none
+*/
+inline SpectrumFamily spectrumFamily(const std::string& name)
+{
+    for (int f = 0; f < SpectrumFamilyCount; f++)
+        if (name == SpectrumCases<float>::name((SpectrumFamily)f))
+            return (SpectrumFamily)f;
+    return SpectrumFamilyCount;
+}
+
+/**
+   The StructureFamily of a case family name, StructureFamilyCount if there is none
+*/
+inline StructureFamily structureFamily(const std::string& name)
+{
+    for (int f = 0; f < StructureFamilyCount; f++)
+        if (name == StructureCases<float>::name((StructureFamily)f))
+            return (StructureFamily)f;
+    return StructureFamilyCount;
+}
+
+/**
+   Number that may be given as a multiple of the machine epsilon of T, e.g. 256eps
+*/
+template <class T>
+T parseScalar(const std::string& s)
+{
+    if (s.size() > 3 && s.compare(s.size() - 3, 3, "eps") == 0)
+        return (T)JIXIE::BENCHMARK::Options::toDouble(s.substr(0, s.size() - 3)) * std::numeric_limits<T>::epsilon();
+    return (T)JIXIE::BENCHMARK::Options::toDouble(s);
+}
+
+/**
+   Generator of a family given as name[:perturbation], see addCases
+*/
+template <class T>
+std::unique_ptr<CaseGenerator<T> > makeCaseGenerator(const std::string& family, const CaseParameters& parameters)
+{
+    size_t colon = family.find(':');
+    std::string name = family.substr(0, colon);
+    std::string perturbation = colon == std::string::npos ? "" : family.substr(colon + 1);
+    if (name == "random")
+        return std::unique_ptr<CaseGenerator<T> >(new UniformCases<T>(parameters.random_count, (T)-parameters.random_range, (T)parameters.random_range, RandomCaseStream));
+    if (name == "integer")
+        return std::unique_ptr<CaseGenerator<T> >(new IntegerCases<T>(parameters.integer_range));
+    if (name == "integer_orbits")
+        return std::unique_ptr<CaseGenerator<T> >(new IntegerOrbits<T>(parameters.integer_range));
+    if (name == "integer_perturbation")
+        return std::unique_ptr<CaseGenerator<T> >(new IntegerPerturbationCases<T>(parameters.integer_range, parameters.perturbation_count, parseScalar<T>(perturbation.empty() ? "256eps" : perturbation)));
+    if (name == "identity_perturbation") {
+        T perturb = parseScalar<T>(perturbation.empty() ? "1e-3" : perturbation);
+        return std::unique_ptr<CaseGenerator<T> >(new UniformCases<T>(parameters.identity_count, -perturb, perturb, IdentityPerturbationStream, Eigen::Matrix<T, 3, 3>::Identity()));
+    }
+    if (spectrumFamily(name) != SpectrumFamilyCount)
+        return std::unique_ptr<CaseGenerator<T> >(new SpectrumCases<T>(parameters.spectrum_count, spectrumFamily(name)));
+    if (structureFamily(name) != StructureFamilyCount)
+        return std::unique_ptr<CaseGenerator<T> >(new StructureCases<T>(parameters.structure_count, (T)parameters.random_range, structureFamily(name)));
+    throw std::invalid_argument("unknown case family " + name);
+}
+
+/**
+   Add the cases of a family given as name[:perturbation]. The families are
+   random, integer, integer_orbits (one integer case per symmetry orbit), integer_perturbation
+   (256eps by default), identity_perturbation (1e-3 by default) and the U diag(sigma) V' families
+   clustered, ill_conditioned, near_rank1, near_inversion and scaled, see SpectrumFamily, and the
+   structured families diagonal, symmetric, bidiagonal, rotation and mixed_structure, see StructureFamily.
+*/
+template <class T>
+void addCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const std::string& family, const CaseParameters& parameters)
+{
+    size_t colon = family.find(':');
+    std::string name = family.substr(0, colon);
+    std::string perturbation = colon == std::string::npos ? "" : family.substr(colon + 1);
+    if (name == "random")
+        addRandomCases(tests, (T)parameters.random_range, parameters.random_count);
+    else if (name == "integer")
+        addIntegerCases(tests, parameters.integer_range);
+    else if (name == "integer_orbits")
+        addIntegerOrbitCases(tests, parameters.integer_range);
+    else if (name == "integer_perturbation")
+        addPerturbationCases(tests, parameters.integer_range, parameters.perturbation_count, parseScalar<T>(perturbation.empty() ? "256eps" : perturbation));
+    else if (name == "identity_perturbation")
+        addPerturbationFromIdentityCases(tests, parameters.identity_count, parseScalar<T>(perturbation.empty() ? "1e-3" : perturbation));
+    else if (spectrumFamily(name) != SpectrumFamilyCount)
+        addSpectrumCases(tests, parameters.spectrum_count, spectrumFamily(name));
+    else if (structureFamily(name) != StructureFamilyCount)
+        addStructureCases(tests, parameters.structure_count, (T)parameters.random_range, structureFamily(name));
+    else
+        throw std::invalid_argument("unknown case family " + name);
+}
+
+/**
+   \brief Max, mean and variance of the accuracy errors, accumulated one decomposition at a time.
+   Every error is the largest absolute entry of a residual.
+   Errors are also counted in ulps, i.e. in units of epsilon * scale where the scale is
+   1 for orthogonality and determinants and the Frobenius norm of the input for the
+   reconstruction and symmetry residuals. A log2 histogram of the ulps and the input
+   with the most ulps are kept for each metric.
+   The storage does not depend on the number of decompositions: mean and variance are
+   updated with Welford's recurrence in double, so that billions of small errors
+   neither swamp the running sum nor lose the variance to cancellation.
+*/
+template <class T>
+class AccuracyErrors {
+public:
+    enum Metric {
+        UUt, // U U' - I, or R R' - I for the polar decomposition
+        VVt, // V V' - I
+        DetU, // |det U| - 1, or det R - 1
+        DetV, // |det V| - 1
+        Reconstruction, // U diag(sigma) V' - A, or R S - F
+        Symmetry, // S - S'
+        MetricCount
+    };
+
+    /**
+       Bucket 0 counts errors below 1 ulp, bucket b > 0 errors in [2^(b-1), 2^b) ulps.
+       The last bucket also takes infinite and NaN errors.
+    */
+    static constexpr int histogram_size = 64;
+
+    /**
+       \brief Everything measured for one metric
+    */
+    struct Accumulator {
+        size_t count = 0;
+        double mean = 0;
+        double m2 = 0; // sum of squared deviations from the mean
+        T maximum = 0;
+        double ulp_sum = 0;
+        T worst_ulps = 0;
+        size_t worst_index = 0;
+        Eigen::Matrix<T, 3, 3> worst_input = Eigen::Matrix<T, 3, 3>::Zero();
+        size_t histogram[histogram_size] = {};
+
+        void add(const T error, const T ulps)
+        {
+            maximum = (error > maximum) ? error : maximum;
+            count++;
+            double delta = (double)error - mean;
+            mean += delta / (double)count;
+            m2 += delta * ((double)error - mean);
+            ulp_sum += ulps;
+            histogram[bucket(ulps)]++;
+        }
+
+        /**
+           Merge n errors summarized by their mean, squared deviations, max and ulp sum.
+           Uses the pairwise update of Chan et al. for the variance.
+        */
+        void addMoments(const size_t n, const double n_mean, const double n_m2, const T n_maximum, const double n_ulp_sum)
+        {
+            if (!n)
+                return;
+            double total = (double)(count + n);
+            double delta = n_mean - mean;
+            mean += delta * (double)n / total;
+            m2 += n_m2 + delta * delta * (double)count * (double)n / total;
+            maximum = (n_maximum > maximum) ? n_maximum : maximum;
+            ulp_sum += n_ulp_sum;
+            count += n;
+        }
+
+        /**
+           True if an error of this many ulps replaces the worst case. NaN beats everything but NaN.
+        */
+        bool worse(const T ulps) const
+        {
+            return ulps > worst_ulps || (ulps != ulps && worst_ulps == worst_ulps);
+        }
+
+        void offerWorst(const T ulps, const size_t index, const Eigen::Matrix<T, 3, 3>& input)
+        {
+            if (!worse(ulps))
+                return;
+            worst_ulps = ulps;
+            worst_index = index;
+            worst_input = input;
+        }
+
+        Accumulator& operator+=(const Accumulator& other)
+        {
+            addMoments(other.count, other.mean, other.m2, other.maximum, other.ulp_sum);
+            if (other.count)
+                offerWorst(other.worst_ulps, other.worst_index, other.worst_input);
+            for (int b = 0; b < histogram_size; b++)
+                histogram[b] += other.histogram[b];
+            return *this;
+        }
+
+        static int bucket(const T ulps)
+        {
+            using std::ilogb;
+            if (ulps < 1)
+                return 0;
+            if (!(ulps < std::ldexp(T(1), histogram_size - 2)))
+                return histogram_size - 1;
+            return ilogb(ulps) + 1;
+        }
+    };
+
+    static const char* name(const Metric m)
+    {
+        static const char* names[MetricCount] = { "UUt", "VVt", "detU", "detV", "recons", "symS" };
+        return names[m];
+    }
+
+    /**
+       \param index Position of A in the test suite, reported with the worst case
+    */
+    template <int dim>
+    void addSVD(const Eigen::Matrix<T, dim, dim>& A,
+        const Eigen::Matrix<T, dim, dim>& U,
+        const Eigen::Matrix<T, dim, 1>& sigma,
+        const Eigen::Matrix<T, dim, dim>& V,
+        const size_t index = 0)
+    {
+        using std::fabs;
+        typedef Eigen::Matrix<T, dim, dim> Matrix;
+        Input<dim> input(A, index);
+        add(UUt, (U * U.transpose() - Matrix::Identity()).array().abs().maxCoeff(), 1, input);
+        add(VVt, (V * V.transpose() - Matrix::Identity()).array().abs().maxCoeff(), 1, input);
+        add(DetU, fabs(fabs(U.determinant()) - (T)1), 1, input);
+        add(DetV, fabs(fabs(V.determinant()) - (T)1), 1, input);
+        add(Reconstruction, (U * sigma.asDiagonal() * V.transpose() - A).array().abs().maxCoeff(), A.norm(), input);
+    }
+
+    void addPolar(const Eigen::Matrix<T, 3, 3>& F, const Eigen::Matrix<T, 3, 3>& R, const Eigen::Matrix<T, 3, 3>& S, const size_t index = 0)
+    {
+        using std::fabs;
+        Input<3> input(F, index);
+        T scale = F.norm();
+        add(UUt, (R * R.transpose() - Eigen::Matrix<T, 3, 3>::Identity()).array().abs().maxCoeff(), 1, input);
+        add(DetU, fabs(R.determinant() - (T)1), 1, input);
+        add(Reconstruction, (R * S - F).array().abs().maxCoeff(), scale, input);
+        add(Symmetry, (S - S.transpose()).array().abs().maxCoeff(), scale, input);
+    }
+
+    void addPolar(const Eigen::Matrix<T, 3, 3>& F, const Eigen::Matrix<T, 3, 3>& R, const SymmetricMatrix3<T>& S, const size_t index = 0)
+    {
+        addPolar(F, R, S.toDense(), index);
+    }
+
+    /**
+       NaN for a metric that was never measured
+    */
+    T max(const Metric m) const
+    {
+        return metrics[m].count ? metrics[m].maximum : std::numeric_limits<T>::quiet_NaN();
+    }
+
+    T average(const Metric m) const
+    {
+        return metrics[m].count ? (T)metrics[m].mean : std::numeric_limits<T>::quiet_NaN();
+    }
+
+    /**
+       Sample standard deviation, NaN with fewer than two measurements
+    */
+    T standardDeviation(const Metric m) const
+    {
+        using std::sqrt;
+        return metrics[m].count > 1 ? (T)sqrt(metrics[m].m2 / (double)(metrics[m].count - 1)) : std::numeric_limits<T>::quiet_NaN();
+    }
+
+    size_t count(const Metric m) const
+    {
+        return metrics[m].count;
+    }
+
+    T maxUlps(const Metric m) const
+    {
+        return metrics[m].count ? metrics[m].worst_ulps : std::numeric_limits<T>::quiet_NaN();
+    }
+
+    T averageUlps(const Metric m) const
+    {
+        return metrics[m].count ? (T)(metrics[m].ulp_sum / (double)metrics[m].count) : std::numeric_limits<T>::quiet_NaN();
+    }
+
+    /**
+       The whole record of one metric: histogram, worst input and its index.
+       Inputs smaller than 3x3 sit in the top left corner of worst_input.
+    */
+    const Accumulator& metric(const Metric m) const
+    {
+        return metrics[m];
+    }
+
+    Accumulator& metric(const Metric m)
+    {
+        return metrics[m];
+    }
+
+    /**
+       error / (epsilon * scale), with 0 / 0 = 0 for a zero input reproduced exactly
+    */
+    static T ulpsOf(const T error, const T scale)
+    {
+        if (scale > 0)
+            return error / (std::numeric_limits<T>::epsilon() * scale);
+        return error > 0 ? std::numeric_limits<T>::infinity() : error;
+    }
+
+    /**
+       \brief Merge the errors of another run, as if they had been added here.
+    */
+    AccuracyErrors& operator+=(const AccuracyErrors& other)
+    {
+        for (int m = 0; m < MetricCount; m++)
+            metrics[m] += other.metrics[m];
+        return *this;
+    }
+
+private:
+    Accumulator metrics[MetricCount];
+
+    /**
+       The input is only copied out when it becomes a worst case
+    */
+    template <int dim>
+    struct Input {
+        const Eigen::Matrix<T, dim, dim>& A;
+        size_t index;
+        Input(const Eigen::Matrix<T, dim, dim>& A, const size_t index)
+            : A(A)
+            , index(index)
+        {
+        }
+        Eigen::Matrix<T, 3, 3> padded() const
+        {
+            Eigen::Matrix<T, 3, 3> M = Eigen::Matrix<T, 3, 3>::Zero();
+            M.template topLeftCorner<dim, dim>() = A;
+            return M;
+        }
+    };
+
+    template <int dim>
+    void add(const Metric m, const T error, const T scale, const Input<dim>& input)
+    {
+        T ulps = ulpsOf(error, scale);
+        metrics[m].add(error, ulps);
+        if (metrics[m].worse(ulps))
+            metrics[m].offerWorst(ulps, input.index, input.padded());
+    }
+};
+
+/**
+   \brief Accuracy of n batched 3X3 SVDs stored as streams, see batchSingularValueDecomposition.
+   W matrices are checked at once with SIMD::Pack. Each lane keeps its own Welford
+   moments, flushed into errors every few hundred packs, so float lanes never
+   accumulate long. Matrices past the last full pack go through addSVD.
+   \param first_index Index of the first matrix in the whole suite, for the worst cases
+*/
+template <class T, int W = SIMD::NativeWidth<T>::value>
+void checkSVD(AccuracyErrors<T>& errors,
+    const size_t n,
+    const T* const A[9],
+    const T* const U[9],
+    const T* const sigma[3],
+    const T* const V[9],
+    const size_t first_index = 0)
+{
+    typedef SIMD::Pack<T, W> P;
+    typedef typename P::Vec Vec;
+    typedef typename P::Mask Mask;
+    typedef typename P::MaskScalar MaskScalar;
+    typedef AccuracyErrors<T> Errors;
+    const int metric_count = 5; // UUt, VVt, DetU, DetV, Reconstruction, in the order of Errors::Metric
+    const size_t flush = 256;
+    const int mantissa_bits = std::numeric_limits<T>::digits - 1;
+    const MaskScalar exponent_mask = sizeof(T) == 4 ? 0xff : 0x7ff;
+    const MaskScalar exponent_bias = sizeof(T) == 4 ? 127 : 1023;
+    const Vec zero = P::broadcast(0), one = P::broadcast(1), epsilon = P::broadcast(std::numeric_limits<T>::epsilon());
+    const Vec infinity = P::broadcast(std::numeric_limits<T>::infinity());
+
+    auto get = [](const T* const* streams, const int k, const size_t i) { return P::load(streams[k] + i); };
+    auto orthogonality = [&](const T* const* M, const size_t i) {
+        Vec m[9];
+        for (int k = 0; k < 9; k++)
+            m[k] = get(M, k, i);
+        Vec e = zero;
+        for (int r = 0; r < 3; r++)
+            for (int c = r; c < 3; c++) {
+                Vec d = m[r] * m[c] + m[r + 3] * m[c + 3] + m[r + 6] * m[c + 6] - (r == c ? one : zero);
+                e = P::select(P::abs(d) > e, P::abs(d), e);
+            }
+        return e;
+    };
+    auto determinant = [&](const T* const* M, const size_t i) {
+        Vec m[9];
+        for (int k = 0; k < 9; k++)
+            m[k] = get(M, k, i);
+        // expanded along the first row in the same order as Eigen's 3x3 determinant
+        Vec det = m[0] * (m[4] * m[8] - m[7] * m[5]) - m[3] * (m[1] * m[8] - m[7] * m[2]) + m[6] * (m[1] * m[5] - m[4] * m[2]);
+        return P::abs(P::abs(det) - one);
+    };
+
+    size_t packs = n / W;
+    for (size_t first_pack = 0; first_pack < packs; first_pack += flush) {
+        size_t last_pack = std::min(packs, first_pack + flush);
+        Vec mean[metric_count], m2[metric_count], maximum[metric_count], ulp_sum[metric_count], worst[metric_count];
+        Mask worst_pack[metric_count];
+        for (int m = 0; m < metric_count; m++) {
+            mean[m] = m2[m] = maximum[m] = ulp_sum[m] = zero;
+            worst[m] = P::broadcast(-1);
+            worst_pack[m] = (Mask)zero;
+        }
+        for (size_t pack = first_pack; pack < last_pack; pack++) {
+            size_t i = pack * W;
+            Vec error[metric_count], scale[metric_count];
+            error[Errors::UUt] = orthogonality(U, i);
+            error[Errors::VVt] = orthogonality(V, i);
+            error[Errors::DetU] = determinant(U, i);
+            error[Errors::DetV] = determinant(V, i);
+            Vec recons = zero, norm2 = zero;
+            for (int r = 0; r < 3; r++)
+                for (int c = 0; c < 3; c++) {
+                    Vec a = get(A, r + 3 * c, i);
+                    Vec d = get(U, r, i) * get(sigma, 0, i) * get(V, c, i) + get(U, r + 3, i) * get(sigma, 1, i) * get(V, c + 3, i)
+                        + get(U, r + 6, i) * get(sigma, 2, i) * get(V, c + 6, i) - a;
+                    recons = P::select(P::abs(d) > recons, P::abs(d), recons);
+                    norm2 += a * a;
+                }
+            error[Errors::Reconstruction] = recons;
+            scale[Errors::UUt] = scale[Errors::VVt] = scale[Errors::DetU] = scale[Errors::DetV] = one;
+            scale[Errors::Reconstruction] = P::sqrt(norm2);
+
+            Vec k = P::broadcast((T)(pack - first_pack + 1));
+            for (int m = 0; m < metric_count; m++) {
+                Vec x = error[m];
+                Vec ulps = x / (epsilon * scale[m]);
+                ulps = P::select(scale[m] > zero, ulps, P::select(x > zero, infinity, x));
+                maximum[m] = P::select(x > maximum[m], x, maximum[m]);
+                Vec delta = x - mean[m];
+                mean[m] += delta / k;
+                m2[m] += delta * (x - mean[m]);
+                ulp_sum[m] += ulps;
+                Mask replace = (ulps > worst[m]) | ((ulps != ulps) & (worst[m] == worst[m]));
+                worst[m] = P::select(replace, ulps, worst[m]);
+                worst_pack[m] = replace ? (Mask)P::broadcast(0) + (MaskScalar)pack : worst_pack[m];
+
+                // log2 bucket straight from the exponent bits, denormals fall into bucket 0
+                Mask exponent = (((Mask)ulps >> mantissa_bits) & exponent_mask) - exponent_bias + 1;
+                exponent = exponent < 0 ? (Mask)zero : exponent;
+                exponent = exponent > Errors::histogram_size - 1 ? (Mask)zero + (MaskScalar)(Errors::histogram_size - 1) : exponent;
+                typename Errors::Accumulator& accumulator = errors.metric((typename Errors::Metric)m);
+                for (int l = 0; l < W; l++)
+                    accumulator.histogram[exponent[l]]++;
+            }
+        }
+        size_t count = last_pack - first_pack;
+        for (int m = 0; m < metric_count; m++) {
+            typename Errors::Accumulator& accumulator = errors.metric((typename Errors::Metric)m);
+            for (int l = 0; l < W; l++) {
+                accumulator.addMoments(count, mean[m][l], m2[m][l], maximum[m][l], ulp_sum[m][l]);
+                if (accumulator.worse(worst[m][l])) {
+                    size_t i = (size_t)worst_pack[m][l] * W + l;
+                    Eigen::Matrix<T, 3, 3> input;
+                    for (int k = 0; k < 9; k++)
+                        input(k) = A[k][i];
+                    accumulator.offerWorst(worst[m][l], first_index + i, input);
+                }
+            }
+        }
+    }
+
+    for (size_t i = packs * W; i < n; i++) {
+        Eigen::Matrix<T, 3, 3> a, u, v;
+        Eigen::Matrix<T, 3, 1> s;
+        for (int k = 0; k < 9; k++) {
+            a(k) = A[k][i];
+            u(k) = U[k][i];
+            v(k) = V[k][i];
+        }
+        for (int k = 0; k < 3; k++)
+            s(k) = sigma[k][i];
+        errors.addSVD(a, u, s, v, first_index + i);
+    }
+}
+
+/**
+   \brief checkSVD spread over a thread pool, one accumulator per thread merged at the end.
+   The grain is rounded up to a multiple of the SIMD width so only the very last chunk has a tail.
+*/
+template <class T, int W = SIMD::NativeWidth<T>::value>
+AccuracyErrors<T> parallelCheckSVD(ThreadPool& pool,
+    const size_t n,
+    const T* const A[9],
+    const T* const U[9],
+    const T* const sigma[3],
+    const T* const V[9],
+    size_t grain = 4096)
+{
+    grain = (grain + W - 1) / W * W;
+    std::vector<AccuracyErrors<T> > thread_errors(pool.size());
+    pool.parallelFor(n, grain, [&](size_t begin, size_t end, int thread_id) {
+        const T *a[9], *u[9], *s[3], *v[9];
+        for (int k = 0; k < 9; k++) {
+            a[k] = A[k] + begin;
+            u[k] = U[k] + begin;
+            v[k] = V[k] + begin;
+        }
+        for (int k = 0; k < 3; k++)
+            s[k] = sigma[k] + begin;
+        checkSVD<T, W>(thread_errors[thread_id], end - begin, a, u, s, v, begin);
+    });
+    AccuracyErrors<T> errors;
+    for (const AccuracyErrors<T>& e : thread_errors)
+        errors += e;
+    return errors;
+}
+}
+#endif
@@ -0,0 +1,198 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   This file provides a persistent thread pool with static chunked partitioning.
+   Sample usage:
+   JIXIE::ThreadPool pool(8);  // the calling thread is worker 0
+   pool.parallelFor(n, 1024, [&](size_t begin, size_t end, int thread_id) {
+       for (size_t i = begin; i < end; i++)
+           work(i);
+   });
+   ################################################################################
+*/
+
+#ifndef JIXIE_THREAD_POOL_H
+#define JIXIE_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace JIXIE {
+
+/**
+   Thread pool whose workers live as long as the pool.
+   Work is split into chunks of grain items and chunk c goes to thread c % size(),
+   so the same thread always sees the same part of the data from call to call.
+*/
+class ThreadPool {
+public:
+    /**
+       \param threads Number of threads including the caller. 0 means hardware concurrency.
+       \param pin Pin worker i to the i-th cpu the process is allowed to run on.
+    */
+    ThreadPool(int threads = 0, bool pin = true)
+        : generation(0)
+        , remaining(0)
+        , stop(false)
+    {
+        if (threads <= 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<int> cpus = allowedCpus();
+        for (int t = 1; t < threads; t++) {
+            workers.emplace_back([this, t] { workerLoop(t); });
+            if (pin && !cpus.empty())
+                pinThread(workers.back().native_handle(), cpus[t % cpus.size()]);
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        start_condition.notify_all();
+        for (auto& w : workers)
+            w.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const
+    {
+        return (int)workers.size() + 1;
+    }
+
+    /**
+       Run f(begin, end, thread_id) over [0, n) in chunks of grain items.
+       Returns when every chunk is done.
+    */
+    void parallelFor(const size_t n, size_t grain, const std::function<void(size_t, size_t, int)>& f)
+    {
+        grain = std::max<size_t>(grain, 1);
+        if (workers.empty() || n <= grain) {
+            runChunks(n, grain, f, 0, 1);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &f;
+            job_size = n;
+            job_grain = grain;
+            remaining = (int)workers.size();
+            generation++;
+        }
+        start_condition.notify_all();
+        runChunks(n, grain, f, 0, size());
+        std::unique_lock<std::mutex> lock(mutex);
+        done_condition.wait(lock, [this] { return remaining == 0; });
+        job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start_condition;
+    std::condition_variable done_condition;
+    const std::function<void(size_t, size_t, int)>* job = nullptr;
+    size_t job_size = 0;
+    size_t job_grain = 1;
+    size_t generation;
+    int remaining;
+    bool stop;
+
+    static void runChunks(const size_t n, const size_t grain, const std::function<void(size_t, size_t, int)>& f, const int thread_id, const int threads)
+    {
+        for (size_t begin = thread_id * grain; begin < n; begin += threads * grain)
+            f(begin, std::min(begin + grain, n), thread_id);
+    }
+
+    void workerLoop(const int thread_id)
+    {
+        size_t seen = 0;
+        while (true) {
+            const std::function<void(size_t, size_t, int)>* f;
+            size_t n, grain;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start_condition.wait(lock, [&] { return stop || generation != seen; });
+                if (stop)
+                    return;
+                seen = generation;
+                f = job;
+                n = job_size;
+                grain = job_grain;
+            }
+            runChunks(n, grain, *f, thread_id, size());
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0)
+                done_condition.notify_one();
+        }
+    }
+
+    static std::vector<int> allowedCpus()
+    {
+        std::vector<int> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+            for (int c = 0; c < CPU_SETSIZE; c++)
+                if (CPU_ISSET(c, &set))
+                    cpus.push_back(c);
+#endif
+        return cpus;
+    }
+
+    static void pinThread(std::thread::native_handle_type handle, const int cpu)
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(handle, sizeof(set), &set);
+#else
+        (void)handle;
+        (void)cpu;
+#endif
+    }
+};
+}
+#endif
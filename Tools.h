@@ -28,17 +28,31 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 
 ################################################################################
-This file provides a random number generator and a timer.
+This file provides random number generators, timers and hardware performance counters.
 Sample usage:
     RandomNumber<float> rand;
     float x = randReal(-0.5, 0.8);
 
+    PhiloxRandomNumber<float> philox(123); // counter based, the i-th number never depends on the others
+    float y = philox.uniform(i, -0.5, 0.8);
+    philox.fill(x_array, n, first, -0.5, 0.8); // numbers first to first + n - 1, from any thread
+
     Timer timer;
     timer.start();
     SOME CODE A
     std::cout<<"CODE A took "<<timer.click()<<" seconds"<<std::endl;
     SOME CODE B
     std::cout<<"CODE B took "<<timer.click()<<" seconds"<<std::endl;
+
+    uint64_t begin = CycleTimer::start(); // serialized rdtsc, for single decompositions
+    SOME SHORT CODE
+    double ns = CycleTimer::nanoseconds(CycleTimer::stop() - begin - CycleTimer::overhead());
+
+    PerfCounters counters; // hardware events of this thread through perf_event_open, NaN where unavailable
+    counters.start();
+    SOME CODE
+    counters.stop();
+    double ipc = counters.count(PerfCounters::Instructions) / counters.count(PerfCounters::Cycles);
 ################################################################################
 */
 
@@ -54,11 +68,27 @@ Sample usage:
 
 #include <mmintrin.h>
 #include <xmmintrin.h>
+#include <immintrin.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <random>
 #include <chrono>
 #include <iostream>
 #include <iomanip>
+#include <limits>
 
 namespace JIXIE {
 
@@ -99,6 +129,232 @@ public:
     }
 };
 
+/**
+   \brief Counter based random numbers, Philox-4x32-10 of Salmon et al., "Parallel random numbers: as easy as 1, 2, 3".
+
+   The i-th number of a stream is a fixed function of (seed, stream, i), so any range
+   of the sequence can be generated on its own: threads that split a fill between them
+   produce the same numbers as one thread, whatever their number. Each block of four
+   32 bit words gives four floats or two doubles in [0, 1), with 23 and 52 random bits.
+   Numbers are laid out batch by batch: number w * batch + j of a batch comes from
+   word w of its block j, so that fill stores whole vectors.
+*/
+template <class T>
+class PhiloxRandomNumber {
+public:
+    static constexpr int per_block = sizeof(T) == 4 ? 4 : 2;
+    static constexpr int batch = 16; // blocks per batch, fixed so that every build makes the same numbers
+
+    PhiloxRandomNumber(uint64_t seed = 123, uint64_t stream = 0)
+        : key0((uint32_t)seed)
+        , key1((uint32_t)(seed >> 32))
+        , stream0((uint32_t)stream)
+        , stream1((uint32_t)(stream >> 32))
+        , position(0)
+    {
+    }
+
+    /**
+       Block number counter of the stream, the raw output of the generator
+    */
+    void block(const uint64_t counter, uint32_t out[4]) const
+    {
+        uint32_t c0 = (uint32_t)counter, c1 = (uint32_t)(counter >> 32), c2 = stream0, c3 = stream1;
+        uint32_t k0 = key0, k1 = key1;
+        for (int round = 0; round < 10; round++) {
+            uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+            uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+            uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+            uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+            c1 = (uint32_t)p1;
+            c3 = (uint32_t)p0;
+            c0 = n0;
+            c2 = n2;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+    /**
+       The i-th number of the stream, uniform in [a, b)
+    */
+    T uniform(const uint64_t i, const T a, const T b) const
+    {
+        const uint64_t group = batch * per_block;
+        int r = (int)(i % group);
+        uint32_t words[4];
+        block(i / group * batch + r % batch, words);
+        return a + rounded((b - a) * toUnit(words, r / batch));
+    }
+
+    /**
+       x[j] = number first + j of the stream, uniform in [a, b), for j < n.
+       Whole batches run the rounds on vectors of 64 bit lanes, the ragged ends go through uniform.
+    */
+    void fill(T* x, size_t n, uint64_t first, const T a, const T b) const
+    {
+        const uint64_t group = batch * per_block;
+        while (n && first % group) {
+            *x++ = uniform(first++, a, b);
+            n--;
+        }
+        const Output va = broadcast(a), scale = broadcast(b - a), one = broadcast(1);
+        for (uint64_t counter = first / per_block; n >= group; n -= group, x += group, first += group, counter += batch) {
+            // the 32 bit words are held in 64 bit lanes, so that the 32 x 32 -> 64 bit products stay in their lane
+            Lanes c0[vectors], c1[vectors], c2[vectors], c3[vectors];
+            for (int v = 0; v < vectors; v++)
+                for (int j = 0; j < lanes; j++) {
+                    uint64_t block_counter = counter + v * lanes + j;
+                    c0[v][j] = (uint32_t)block_counter;
+                    c1[v][j] = block_counter >> 32;
+                    c2[v][j] = stream0;
+                    c3[v][j] = stream1;
+                }
+            uint32_t k0 = key0, k1 = key1;
+            for (int round = 0; round < 10; round++) {
+                for (int v = 0; v < vectors; v++) {
+                    Lanes p0 = multiply(c0[v], 0xD2511F53u);
+                    Lanes p1 = multiply(c2[v], 0xCD9E8D57u);
+                    Lanes n0 = (p1 >> 32) ^ c1[v] ^ (uint64_t)k0;
+                    Lanes n2 = (p0 >> 32) ^ c3[v] ^ (uint64_t)k1;
+                    c1[v] = p1 & (uint64_t)0xffffffffu;
+                    c3[v] = p0 & (uint64_t)0xffffffffu;
+                    c0[v] = n0;
+                    c2[v] = n2;
+                }
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            for (int v = 0; v < vectors; v++) {
+                Lanes words[4] = { c0[v], c1[v], c2[v], c3[v] };
+                for (int w = 0; w < per_block; w++) {
+                    Output u = toUnit(words, w) - one;
+                    u = va + rounded(scale * u);
+                    std::memcpy(x + w * batch + v * lanes, &u, sizeof(u));
+                }
+            }
+        }
+        for (size_t j = 0; j < n; j++)
+            x[j] = uniform(first + j, a, b);
+    }
+
+    /**
+       Sequential use, a drop in for RandomNumber: fills x with the next x.size() numbers
+    */
+    template <class Derived>
+    void fill(Eigen::DenseBase<Derived>& x, T a, T b)
+    {
+        for (typename Derived::Index i = 0; i < x.size(); i++)
+            x(i) = uniform(position++, a, b);
+    }
+
+    T randReal(T a, T b)
+    {
+        return uniform(position++, a, b);
+    }
+
+    /**
+       Jump ahead (or back) in constant time
+    */
+    void seek(const uint64_t i)
+    {
+        position = i;
+    }
+
+    void discard(const uint64_t n)
+    {
+        position += n;
+    }
+
+private:
+#if defined(__AVX512F__)
+    static constexpr int lanes = 8;
+#elif defined(__AVX2__)
+    static constexpr int lanes = 4;
+#else
+    static constexpr int lanes = 2;
+#endif
+    static constexpr int vectors = batch / lanes;
+    typedef uint64_t Lanes __attribute__((vector_size(lanes * sizeof(uint64_t))));
+    typedef uint32_t Lanes32 __attribute__((vector_size(lanes * sizeof(uint32_t))));
+    typedef T Output __attribute__((vector_size(lanes * sizeof(T))));
+
+    uint32_t key0, key1, stream0, stream1;
+    uint64_t position;
+
+    /**
+       32 x 32 -> 64 bit products of the low halves of the lanes. GCC turns a plain
+       64 bit vector multiply into vpmullq or scalar code, pmuludq is much shorter.
+    */
+    static Lanes multiply(const Lanes x, const uint32_t m)
+    {
+#if defined(__AVX512F__)
+        return (Lanes)_mm512_mul_epu32((__m512i)x, _mm512_set1_epi64(m));
+#elif defined(__AVX2__)
+        return (Lanes)_mm256_mul_epu32((__m256i)x, _mm256_set1_epi64x(m));
+#else
+        return (Lanes)_mm_mul_epu32((__m128i)x, _mm_set1_epi64x(m));
+#endif
+    }
+
+    /**
+       x as is. The product stays rounded before the sum that follows instead of being
+       contracted into an fma, so builds with and without FMA make the same numbers.
+    */
+    template <class V>
+    static V rounded(V x)
+    {
+        __asm__("" : "+v"(x));
+        return x;
+    }
+
+    static Output broadcast(const T x)
+    {
+        Output v;
+        for (int j = 0; j < lanes; j++)
+            v[j] = x;
+        return v;
+    }
+
+    /**
+       Random bits under the exponent of 1, i.e. a number in [1, 2)
+    */
+    static Output toUnit(const Lanes words[4], const int w)
+    {
+        Output u;
+        if (sizeof(T) == 4) {
+            Lanes32 bits = __builtin_convertvector((words[w] >> 9) | (uint64_t)0x3f800000u, Lanes32);
+            std::memcpy(&u, &bits, sizeof(u));
+        }
+        else {
+            Lanes bits = ((words[2 * w] << 20) ^ (words[2 * w + 1] >> 12)) | (uint64_t)0x3ff0000000000000ull;
+            std::memcpy(&u, &bits, sizeof(u));
+        }
+        return u;
+    }
+
+    /**
+       The same number in [0, 1) for a single block
+    */
+    static T toUnit(const uint32_t words[4], const int w)
+    {
+        T u;
+        if (sizeof(T) == 4) {
+            uint32_t bits = (words[w] >> 9) | 0x3f800000u;
+            std::memcpy(&u, &bits, sizeof(u));
+        }
+        else {
+            uint64_t bits = (((uint64_t)words[2 * w] << 20) ^ (words[2 * w + 1] >> 12)) | 0x3ff0000000000000ull;
+            std::memcpy(&u, &bits, sizeof(u));
+        }
+        return u - 1;
+    }
+};
+
 namespace MATH_TOOLS {
 
 /**
@@ -133,8 +389,74 @@ inline double rsqrt(double a)
 using std::sqrt;
 return 1 / sqrt(a);
 }
+/**
+\brief 2^e, usable in constant expressions
+*/
+template <class T>
+constexpr T powerOfTwo(int e)
+{
+T r = 1;
+for (; e > 0; e--)
+    r *= 2;
+for (; e < 0; e++)
+    r /= 2;
+return r;
+}
 }
 
+/**
+   \brief Symmetric 3X3 matrix stored as its 6 distinct entries in Voigt order: 00, 11, 22, 12, 02, 01
+*/
+template <class T>
+struct SymmetricMatrix3 {
+    T data[6];
+
+    T& operator()(const int i, const int j)
+    {
+        return data[index(i, j)];
+    }
+
+    const T& operator()(const int i, const int j) const
+    {
+        return data[index(i, j)];
+    }
+
+    Eigen::Matrix<T, 3, 3> toDense() const
+    {
+        Eigen::Matrix<T, 3, 3> S;
+        S << data[0], data[5], data[4],
+            data[5], data[1], data[3],
+            data[4], data[3], data[2];
+        return S;
+    }
+
+    /**
+       Upper triangle of S, which is assumed symmetric
+    */
+    static SymmetricMatrix3 fromDense(const Eigen::Matrix<T, 3, 3>& S)
+    {
+        return { { S(0, 0), S(1, 1), S(2, 2), S(1, 2), S(0, 2), S(0, 1) } };
+    }
+
+    static int index(const int i, const int j)
+    {
+        return i == j ? i : 6 - i - j;
+    }
+
+    /**
+       Row and column of entry k in the upper triangle, the inverse of index
+    */
+    static int row(const int k)
+    {
+        return k < 3 ? k : (k == 3 ? 1 : 0);
+    }
+
+    static int col(const int k)
+    {
+        return k < 3 ? k : (k == 5 ? 1 : 2);
+    }
+};
+
 /**
     Timer. We can use either system timer or stready timer
 */
@@ -169,10 +491,310 @@ private:
     std::chrono::duration<double> elapsed_seconds;
 };
 
+/**
+   \brief Cycle counter timer for intervals too short for Timer, e.g. one decomposition.
+   start() and stop() read the time stamp counter with rdtsc after lfence and with rdtscp
+   followed by lfence, so that the timed code can neither start before start() nor end
+   after stop(). The counter runs at a constant rate on cpus with an invariant TSC, which
+   is converted to nanoseconds by a calibration against steady_clock. Other architectures
+   fall back to steady_clock, at 1 tick per ns.
+
+   uint64_t begin = CycleTimer::start();
+   SOME SHORT CODE
+   double ns = CycleTimer::nanoseconds(CycleTimer::stop() - begin - CycleTimer::overhead());
+*/
+class CycleTimer {
+public:
+    static uint64_t start()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_lfence();
+        uint64_t t = __rdtsc();
+        _mm_lfence();
+        return t;
+#else
+        return steadyNanoseconds();
+#endif
+    }
+
+    static uint64_t stop()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int cpu;
+        uint64_t t = __rdtscp(&cpu);
+        _mm_lfence();
+        return t;
+#else
+        return steadyNanoseconds();
+#endif
+    }
+
+    /**
+       Ticks per nanosecond, measured once over 20 ms
+    */
+    static double ticksPerNanosecond()
+    {
+        static const double rate = calibrate();
+        return rate;
+    }
+
+    /**
+       Median ticks of an empty start()/stop() pair, measured once
+    */
+    static uint64_t overhead()
+    {
+        static const uint64_t ticks = measureOverhead();
+        return ticks;
+    }
+
+    static double nanoseconds(const int64_t ticks)
+    {
+        return ticks / ticksPerNanosecond();
+    }
+
+    /**
+       Whether the counter ticks at a constant rate whatever the frequency and sleep states
+    */
+    static bool invariant()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+            return false;
+        __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        return (edx >> 8) & 1;
+#else
+        return true;
+#endif
+    }
+
+private:
+    static uint64_t steadyNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static double calibrate()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        auto begin = std::chrono::steady_clock::now();
+        uint64_t ticks = start();
+        std::chrono::duration<double, std::nano> elapsed;
+        do
+            elapsed = std::chrono::steady_clock::now() - begin;
+        while (elapsed.count() < 2e7);
+        return (stop() - ticks) / elapsed.count();
+#else
+        return 1;
+#endif
+    }
+
+    static uint64_t measureOverhead()
+    {
+        uint64_t ticks[1001];
+        for (uint64_t& t : ticks) {
+            uint64_t begin = start();
+            t = stop() - begin;
+        }
+        std::nth_element(ticks, ticks + 500, ticks + 1001);
+        return ticks[500];
+    }
+};
+
+/**
+   \brief Hardware event counts of the calling thread around code regions, read through Linux perf_event_open.
+   Counts add up over start()/stop() pairs until reset(). Every event is opened on its own, so
+   events the host does not have (e.g. in virtual machines) are just unavailable, and events
+   that do not all fit on the PMU are multiplexed and scaled by the share of time they ran.
+   Unavailable events count NaN. The floating point events are Intel's FP_ARITH_INST_RETIRED
+   (Broadwell and later), which count FMAs twice, and flops() weighs them by their lanes.
+
+   PerfCounters counters;
+   counters.start();
+   SOME CODE
+   counters.stop();
+   double ipc = counters.count(PerfCounters::Instructions) / counters.count(PerfCounters::Cycles);
+*/
+class PerfCounters {
+public:
+    enum Event {
+        Cycles,
+        Instructions,
+        BranchMisses,
+        L1DMisses, // L1 data cache read misses
+        LLCMisses, // last level cache read misses
+        FPScalarDouble,
+        FPScalarSingle,
+        FP128Double,
+        FP128Single,
+        FP256Double,
+        FP256Single,
+        FP512Double,
+        FP512Single,
+        EventCount
+    };
+
+    PerfCounters()
+    {
+        for (int e = 0; e < EventCount; e++)
+            fd[e] = open((Event)e);
+    }
+
+    ~PerfCounters()
+    {
+#ifdef __linux__
+        for (int e = 0; e < EventCount; e++)
+            if (fd[e] >= 0)
+                close(fd[e]);
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available(const Event e) const
+    {
+        return fd[e] >= 0;
+    }
+
+    void reset()
+    {
+        control(Reset);
+    }
+
+    void start()
+    {
+        control(Enable);
+    }
+
+    void stop()
+    {
+        control(Disable);
+    }
+
+    /**
+       Count of event e since the last reset, scaled up if the event was multiplexed
+    */
+    double count(const Event e) const
+    {
+#ifdef __linux__
+        uint64_t value[3]; // count, time enabled, time running
+        if (fd[e] >= 0 && read(fd[e], value, sizeof(value)) == (ssize_t)sizeof(value)) {
+            if (value[2] == 0)
+                return value[0] == 0 ? 0 : std::numeric_limits<double>::quiet_NaN();
+            return (double)value[0] * value[1] / value[2];
+        }
+#endif
+        (void)e;
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    /**
+       Floating point operations since the last reset: FMAs count 2, packed operations count every lane
+    */
+    double flops() const
+    {
+        static const double lanes[] = { 1, 1, 2, 4, 4, 8, 8, 16 };
+        double sum = 0;
+        for (int e = FPScalarDouble; e <= FP512Single; e++)
+            sum += lanes[e - FPScalarDouble] * count((Event)e);
+        return sum;
+    }
+
+    static const char* name(const Event e)
+    {
+        static const char* names[EventCount] = { "cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses",
+            "fp_scalar_double", "fp_scalar_single", "fp_128_double", "fp_128_single", "fp_256_double", "fp_256_single", "fp_512_double", "fp_512_single" };
+        return names[e];
+    }
+
+private:
+    int fd[EventCount];
+
+    enum Request {
+        Reset,
+        Enable,
+        Disable
+    };
+
+    void control(const Request request)
+    {
+#ifdef __linux__
+        static const unsigned long requests[] = { PERF_EVENT_IOC_RESET, PERF_EVENT_IOC_ENABLE, PERF_EVENT_IOC_DISABLE };
+        for (int e = 0; e < EventCount; e++)
+            if (fd[e] >= 0)
+                ioctl(fd[e], requests[request], 0);
+#else
+        (void)request;
+#endif
+    }
+
+    static bool intel()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int eax, ebx, ecx, edx;
+        return __get_cpuid(0, &eax, &ebx, &ecx, &edx) && ebx == 0x756e6547 && edx == 0x49656e69 && ecx == 0x6c65746e; // GenuineIntel
+#else
+        return false;
+#endif
+    }
+
+    static int open(const Event e)
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        const uint64_t read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        switch (e) {
+        case Cycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case Instructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case BranchMisses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case L1DMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | read_miss;
+            break;
+        case LLCMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_LL | read_miss;
+            break;
+        default:
+            // FP_ARITH_INST_RETIRED, event 0xC7 with one umask bit per width and precision
+            if (!intel())
+                return -1;
+            attr.type = PERF_TYPE_RAW;
+            attr.config = 0xC7 | ((uint64_t)1 << (e - FPScalarDouble)) << 8;
+            break;
+        }
+        return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+        (void)e;
+        return -1;
+#endif
+    }
+};
+
 namespace INTERNAL {
 using namespace std;
+// No type for anything else, so that overloads taking ScalarType<T> drop out quietly
 template <class T, class Enable = void>
 struct ScalarTypeHelper {
+};
+template <class T>
+struct ScalarTypeHelper<T, conditional_t<true, void, typename T::Scalar> > {
     using type = typename T::Scalar;
 };
 template <class T>
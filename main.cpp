@@ -25,182 +25,422 @@ SOFTWARE.
 */
 
 #include <cmath>
+#include <memory>
 #include "Tools.h"
 #include "ImplicitQRSVD.h"
+#include "QuaternionJacobiSVD.h"
+#include "BatchSVD.h"
+#include "SmallStrainPolar.h"
+#include "ParallelSVD.h"
+#include "DispatchSVD.h"
+#include "Benchmark.h"
+#include "TestCases.h"
 
 template <class T>
-void testAccuracy(const std::vector<Eigen::Matrix<T, 3, 3> >& AA,
-    const std::vector<Eigen::Matrix<T, 3, 3> >& UU,
-    const std::vector<Eigen::Matrix<T, 3, 1> >& SS,
-    const std::vector<Eigen::Matrix<T, 3, 3> >& VV)
+void printAccuracy(const JIXIE::AccuracyErrors<T>& errors)
 {
-    T max_UUt_error = 0, max_VVt_error = 0, max_detU_error = 0, max_detV_error = 0, max_reconstruction_error = 0;
-    T ave_UUt_error = 0, ave_VVt_error = 0, ave_detU_error = 0, ave_detV_error = 0, ave_reconstruction_error = 0;
-    for (size_t i = 0; i < AA.size(); i++) {
-        Eigen::Matrix<T, 3, 3> M = AA[i];
-        Eigen::Matrix<T, 3, 1> S = SS[i];
-        Eigen::Matrix<T, 3, 3> U = UU[i];
-        Eigen::Matrix<T, 3, 3> V = VV[i];
-        T error;
-        error = (U * U.transpose() - Eigen::Matrix<T, 3, 3>::Identity()).array().abs().maxCoeff();
-        max_UUt_error = (error > max_UUt_error) ? error : max_UUt_error;
-        ave_UUt_error += fabs(error);
-        error = (V * V.transpose() - Eigen::Matrix<T, 3, 3>::Identity()).array().abs().maxCoeff();
-        max_VVt_error = (error > max_VVt_error) ? error : max_VVt_error;
-        ave_VVt_error += fabs(error);
-        error = fabs(fabs(U.determinant()) - (T)1);
-        max_detU_error = (error > max_detU_error) ? error : max_detU_error;
-        ave_detU_error += fabs(error);
-        error = fabs(fabs(V.determinant()) - (T)1);
-        max_detV_error = (error > max_detV_error) ? error : max_detV_error;
-        ave_detV_error += fabs(error);
-        error = (U * S.asDiagonal() * V.transpose() - M).array().abs().maxCoeff();
-        max_reconstruction_error = (error > max_reconstruction_error) ? error : max_reconstruction_error;
-        ave_reconstruction_error += fabs(error);
-    }
-    ave_UUt_error /= (T)(AA.size());
-    ave_VVt_error /= (T)(AA.size());
-    ave_detU_error /= (T)(AA.size());
-    ave_detV_error /= (T)(AA.size());
-    ave_reconstruction_error /= (T)(AA.size());
-    std::cout << std::setprecision(10) << " UUt max error: " << max_UUt_error
-              << " VVt max error: " << max_VVt_error
-              << " detU max error:" << max_detU_error
-              << " detV max error:" << max_detV_error
-              << " recons max error:" << max_reconstruction_error << std::endl;
-    std::cout << std::setprecision(10) << " UUt ave error: " << ave_UUt_error
-              << " VVt ave error: " << ave_VVt_error
-              << " detU ave error:" << ave_detU_error
-              << " detV ave error:" << ave_detV_error
-              << " recons ave error:" << ave_reconstruction_error << std::endl;
+    typedef JIXIE::AccuracyErrors<T> Errors;
+    std::cout << std::setprecision(10) << " UUt max error: " << errors.max(Errors::UUt)
+              << " VVt max error: " << errors.max(Errors::VVt)
+              << " detU max error:" << errors.max(Errors::DetU)
+              << " detV max error:" << errors.max(Errors::DetV)
+              << " recons max error:" << errors.max(Errors::Reconstruction) << std::endl;
+    std::cout << std::setprecision(10) << " UUt ave error: " << errors.average(Errors::UUt)
+              << " VVt ave error: " << errors.average(Errors::VVt)
+              << " detU ave error:" << errors.average(Errors::DetU)
+              << " detV ave error:" << errors.average(Errors::DetV)
+              << " recons ave error:" << errors.average(Errors::Reconstruction) << std::endl;
+    std::cout << std::setprecision(10) << " UUt std error: " << errors.standardDeviation(Errors::UUt)
+              << " VVt std error: " << errors.standardDeviation(Errors::VVt)
+              << " detU std error:" << errors.standardDeviation(Errors::DetU)
+              << " detV std error:" << errors.standardDeviation(Errors::DetV)
+              << " recons std error:" << errors.standardDeviation(Errors::Reconstruction) << std::endl;
+    std::cout << std::setprecision(4) << " UUt max ulps: " << errors.maxUlps(Errors::UUt)
+              << " VVt max ulps: " << errors.maxUlps(Errors::VVt)
+              << " detU max ulps:" << errors.maxUlps(Errors::DetU)
+              << " detV max ulps:" << errors.maxUlps(Errors::DetV)
+              << " recons max ulps:" << errors.maxUlps(Errors::Reconstruction) << std::endl;
+    std::cout << std::setprecision(4) << " UUt ave ulps: " << errors.averageUlps(Errors::UUt)
+              << " VVt ave ulps: " << errors.averageUlps(Errors::VVt)
+              << " detU ave ulps:" << errors.averageUlps(Errors::DetU)
+              << " detV ave ulps:" << errors.averageUlps(Errors::DetV)
+              << " recons ave ulps:" << errors.averageUlps(Errors::Reconstruction) << std::endl;
+    // ulp histograms, bucket b > 0 holds [2^(b-1), 2^b), and the input with the most ulps
+    for (int m = 0; m < Errors::MetricCount; m++) {
+        const typename Errors::Accumulator& metric = errors.metric((typename Errors::Metric)m);
+        if (!metric.count)
+            continue;
+        std::cout << " " << Errors::name((typename Errors::Metric)m) << " ulps:";
+        for (int b = 0; b < Errors::histogram_size; b++)
+            if (metric.histogram[b])
+                std::cout << (b ? " 2^" : " <1:") << (b ? std::to_string(b - 1) + ":" : "") << metric.histogram[b];
+        Eigen::IOFormat row(Eigen::FullPrecision, Eigen::DontAlignCols, " ", "; ", "", "", "[", "]");
+        std::cout << " worst #" << metric.worst_index << " " << metric.worst_input.format(row) << std::endl;
+    }
 }
 
-template <class T>
-void runImplicitQRSVD(const int repeat, const std::vector<Eigen::Matrix<T, 3, 3> >& tests, const bool accuracy_test)
+/**
+   IPC, branch and cache misses per matrix and GFLOP/s of the passes counted by counters.
+   Hosts without any of the events, e.g. most virtual machines, print nothing.
+*/
+void printCounters(const std::string& name, const JIXIE::PerfCounters& counters, const double matrices, const double seconds)
+{
+    using JIXIE::PerfCounters;
+    bool any = false;
+    for (int e = 0; e < PerfCounters::EventCount; e++)
+        any = any || counters.available((PerfCounters::Event)e);
+    if (!any)
+        return;
+    std::cout << std::setprecision(4) << name << " IPC: " << counters.count(PerfCounters::Instructions) / counters.count(PerfCounters::Cycles)
+              << " cycles/matrix: " << counters.count(PerfCounters::Cycles) / matrices
+              << " branch misses/matrix: " << counters.count(PerfCounters::BranchMisses) / matrices
+              << " L1D misses/matrix: " << counters.count(PerfCounters::L1DMisses) / matrices
+              << " LLC misses/matrix: " << counters.count(PerfCounters::LLCMisses) / matrices
+              << " GFLOP/s: " << counters.flops() / seconds * 1e-9 << std::endl;
+}
+
+template <class Engine, class T>
+double runSVD(const std::string& name, const int repeat, const std::vector<Eigen::Matrix<T, 3, 3> >& tests, const bool accuracy_test)
 {
     using namespace JIXIE;
-    std::vector<Eigen::Matrix<T, 3, 3> > UU, VV;
-    std::vector<Eigen::Matrix<T, 3, 1> > SS;
+    AccuracyErrors<T> errors; // checked inside the first timed pass, nothing is stored per case
+    PerfCounters counters; // count every pass that does not check
+    double counted_time = 0;
     JIXIE::Timer timer;
     timer.start();
     double total_time = 0;
     for (int test_iter = 0; test_iter < repeat; test_iter++) {
+        bool check = accuracy_test && test_iter == 0;
+        if (!check)
+            counters.start();
         timer.click();
         for (size_t i = 0; i < tests.size(); i++) {
             Eigen::Matrix<T, 3, 3> M = tests[i];
             Eigen::Matrix<T, 3, 1> S;
             Eigen::Matrix<T, 3, 3> U;
             Eigen::Matrix<T, 3, 3> V;
-            singularValueDecomposition(M, U, S, V);
-            if (accuracy_test && test_iter == 0) {
-                UU.push_back(U);
-                SS.push_back(S);
-                VV.push_back(V);
-            }
+            singularValueDecomposition<Engine>(M, U, S, V);
+            if (check)
+                errors.addSVD(tests[i], U, S, V, i);
         }
         double this_time = timer.click();
+        if (!check) {
+            counters.stop();
+            counted_time += this_time;
+        }
         total_time += this_time;
-        std::cout << std::setprecision(10) << "impQR time: " << this_time << std::endl;
+        std::cout << std::setprecision(10) << name << " time: " << this_time << std::endl;
     }
-    std::cout << std::setprecision(10) << "impQR Average time: " << total_time / (double)(repeat) << std::endl;
+    std::cout << std::setprecision(10) << name << " Average time: " << total_time / (double)(repeat) << std::endl;
+    if (counted_time > 0)
+        printCounters(name, counters, (double)tests.size() * (repeat - accuracy_test), counted_time);
     if (accuracy_test)
-        testAccuracy(tests, UU, SS, VV);
+        printAccuracy(errors);
+    return total_time / (double)(repeat);
 }
 
 template <class T>
-void addRandomCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const T random_range, const int N)
+double runBatchedImplicitQRSVD(const int repeat, const std::vector<Eigen::Matrix<T, 3, 3> >& tests, const bool accuracy_test)
 {
     using namespace JIXIE;
-    int old_count = tests.size();
-    std::cout << std::setprecision(10) << "Adding random test cases with range " << -random_range << " to " << random_range << std::endl;
-    RandomNumber<T> random_gen(123);
-    for (int t = 0; t < N; t++) {
-        Eigen::Matrix<T, 3, 3> Z;
-        random_gen.fill(Z, -random_range, random_range);
-        tests.push_back(Z);
+    size_t n = tests.size();
+    MatrixStreams<T, 3, 3> A(n), U(n), V(n);
+    MatrixStreams<T, 3, 1> S(n);
+    for (size_t i = 0; i < n; i++)
+        A.set(i, tests[i]);
+    PerfCounters counters;
+    JIXIE::Timer timer;
+    timer.start();
+    double total_time = 0;
+    for (int test_iter = 0; test_iter < repeat; test_iter++) {
+        counters.start();
+        timer.click();
+        batchSingularValueDecomposition(n, A.streams(), U.streams(), S.streams(), V.streams());
+        double this_time = timer.click();
+        counters.stop();
+        total_time += this_time;
+        std::cout << std::setprecision(10) << "batchQR time (" << SIMD::NativeWidth<T>::value << " lanes): " << this_time << std::endl;
     }
-    std::cout << std::setprecision(10) << tests.size() - old_count << " cases added." << std::endl;
-    std::cout << std::setprecision(10) << "Total test cases: " << tests.size() << std::endl;
+    std::cout << std::setprecision(10) << "batchQR Average time: " << total_time / (double)(repeat) << std::endl;
+    printCounters("batchQR", counters, (double)n * repeat, total_time);
+    if (accuracy_test) {
+        ThreadPool pool;
+        printAccuracy(parallelCheckSVD<T>(pool, n, A.streams(), U.streams(), S.streams(), V.streams()));
+    }
+    return total_time / (double)(repeat);
 }
 
 template <class T>
-void addIntegerCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const int int_range)
+void runParallelScaling(const std::vector<Eigen::Matrix<T, 3, 3> >& tests)
 {
     using namespace JIXIE;
-    int old_count = tests.size();
-    std::cout << std::setprecision(10) << "Adding integer test cases with range " << -int_range << " to " << int_range << std::endl;
-    Eigen::Matrix<T, 3, 3> Z;
-    Z.fill(-int_range);
-    typename Eigen::Matrix<T, 3, 3>::Index i = 0;
-    tests.push_back(Z);
-    while (i < Eigen::Matrix<T, 3, 3>::SizeAtCompileTime) {
-        if (Z(i) < int_range) {
-            Z(i)++;
-            tests.push_back(Z);
-            i = 0;
-        }
-        else {
-            Z(i) = -int_range;
-            i++;
+    size_t n = tests.size();
+    std::vector<Eigen::Matrix<T, 3, 3> > UU(n), VV(n), RR(n), SS_Sym(n);
+    std::vector<Eigen::Matrix<T, 3, 1> > SS(n);
+    MatrixStreams<T, 3, 3> A(n), U(n), V(n);
+    MatrixStreams<T, 3, 1> S(n);
+    for (size_t i = 0; i < n; i++)
+        A.set(i, tests[i]);
+
+    int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> thread_counts;
+    for (int t = 1; t < max_threads; t *= 2)
+        thread_counts.push_back(t);
+    thread_counts.push_back(max_threads);
+
+    std::cout << "threads   svd time  speedup   polar time  speedup   batchQR time  speedup" << std::endl;
+    double svd_base = 0, polar_base = 0, batch_base = 0;
+    JIXIE::Timer timer;
+    for (int threads : thread_counts) {
+        ThreadPool pool(threads);
+        timer.start();
+        parallelSingularValueDecomposition(pool, n, tests.data(), UU.data(), SS.data(), VV.data());
+        double svd_time = timer.click();
+        parallelPolarDecomposition(pool, n, tests.data(), RR.data(), SS_Sym.data());
+        double polar_time = timer.click();
+        parallelBatchSingularValueDecomposition(pool, n, A.streams(), U.streams(), S.streams(), V.streams());
+        double batch_time = timer.click();
+        if (threads == 1) {
+            svd_base = svd_time;
+            polar_base = polar_time;
+            batch_base = batch_time;
         }
+        std::cout << std::setprecision(4) << std::setw(7) << threads
+                  << std::setw(11) << svd_time << std::setw(9) << svd_base / svd_time
+                  << std::setw(13) << polar_time << std::setw(9) << polar_base / polar_time
+                  << std::setw(15) << batch_time << std::setw(9) << batch_base / batch_time << std::endl;
     }
-    std::cout << std::setprecision(10) << tests.size() - old_count << " cases added." << std::endl;
-    std::cout << std::setprecision(10) << "Total test cases: " << tests.size() << std::endl;
 }
 
+/**
+   Throughput of every instruction set variant this cpu can run, the selected one is marked with *.
+*/
 template <class T>
-void addPerturbationFromIdentityCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const int num_perturbations, const T perturb)
+void runDispatchBenchmark(const std::vector<Eigen::Matrix<T, 3, 3> >& tests)
 {
     using namespace JIXIE;
-    int old_count = tests.size();
-    std::vector<Eigen::Matrix<T, 3, 3> > tests_tmp;
-    Eigen::Matrix<T, 3, 3> Z = Eigen::Matrix<T, 3, 3>::Identity();
-    tests_tmp.push_back(Z);
-    std::cout << std::setprecision(10) << "Adding perturbed identity test cases with perturbation " << perturb << std::endl;
-    RandomNumber<T> random_gen(123);
-    size_t special_cases = tests_tmp.size();
-    for (size_t t = 0; t < special_cases; t++) {
-        for (int i = 0; i < num_perturbations; i++) {
-            random_gen.fill(Z, -perturb, perturb);
-            tests.push_back(tests_tmp[t] + Z);
-        }
+    size_t n = tests.size();
+    std::vector<Eigen::Matrix<T, 3, 3> > UU(n), VV(n), RR(n), SS_Sym(n);
+    std::vector<Eigen::Matrix<T, 3, 1> > SS(n);
+    MatrixStreams<T, 3, 3> A(n), U(n), V(n);
+    MatrixStreams<T, 3, 1> S(n);
+    for (size_t i = 0; i < n; i++)
+        A.set(i, tests[i]);
+
+    const DISPATCH::Kernels& best = DISPATCH::bestKernels();
+    std::cout << "dispatch selected " << best.name << std::endl;
+    std::cout << "variant   svd M/s   polar M/s   batchQR M/s  lanes" << std::endl;
+    JIXIE::Timer timer;
+    PerfCounters counters;
+    for (int i = 0; i < (int)DISPATCH::ISA::Count; i++) {
+        const DISPATCH::Kernels* k = DISPATCH::kernels((DISPATCH::ISA)i);
+        if (!k)
+            continue;
+        const DISPATCH::KernelTable<T>& table = k->table(T());
+        timer.start();
+        table.singularValueDecomposition(n, tests.data(), UU.data(), SS.data(), VV.data());
+        double svd_time = timer.click();
+        table.polarDecomposition(n, tests.data(), RR.data(), SS_Sym.data());
+        double polar_time = timer.click();
+        counters.reset();
+        counters.start();
+        timer.click();
+        table.batchSingularValueDecomposition(n, A.streams(), U.streams(), S.streams(), V.streams(), nullptr);
+        double batch_time = timer.click();
+        counters.stop();
+        std::cout << std::setprecision(4) << std::setw(6) << k->name << (k == &best ? "*" : " ")
+                  << std::setw(10) << n / svd_time * 1e-6 << std::setw(12) << n / polar_time * 1e-6
+                  << std::setw(14) << n / batch_time * 1e-6 << std::setw(7) << table.batch_lanes << std::endl;
+        printCounters(std::string(k->name) + " batchQR", counters, (double)n, batch_time);
     }
-    std::cout << std::setprecision(10) << tests.size() - old_count << " cases added." << std::endl;
-    std::cout << std::setprecision(10) << "Total test cases: " << tests.size() << std::endl;
+}
+
+/**
+   Time of the 3X3 SVD for every SVDOptions. Sigma may only differ by round off.
+*/
+template <int Options, class T>
+double timePartialOutput(const std::vector<Eigen::Matrix<T, 3, 3> >& tests, std::vector<Eigen::Matrix<T, 3, 1> >& SS)
+{
+    using namespace JIXIE;
+    Eigen::Matrix<T, 3, 3> U = Eigen::Matrix<T, 3, 3>::Identity(), V = Eigen::Matrix<T, 3, 3>::Identity();
+    T checksum = 0;
+    JIXIE::Timer timer;
+    timer.start();
+    for (size_t i = 0; i < tests.size(); i++) {
+        singularValueDecomposition<Options>(tests[i], U, SS[i], V);
+        checksum += U(0, 0) + V(0, 0);
+    }
+    double time = timer.click();
+    volatile T sink = checksum;
+    (void)sink;
+    return time;
 }
 
 template <class T>
-void addPerturbationCases(std::vector<Eigen::Matrix<T, 3, 3> >& tests, const int int_range, const int num_perturbations, const T perturb)
+void runPartialOutputBenchmark(const std::vector<Eigen::Matrix<T, 3, 3> >& tests)
 {
     using namespace JIXIE;
-    int old_count = tests.size();
-    std::vector<Eigen::Matrix<T, 3, 3> > tests_tmp;
-    Eigen::Matrix<T, 3, 3> Z;
-    Z.fill(-int_range);
-    typename Eigen::Matrix<T, 3, 3>::Index i = 0;
-    tests_tmp.push_back(Z);
-    while (i < Eigen::Matrix<T, 3, 3>::SizeAtCompileTime) {
-        if (Z(i) < int_range) {
-            Z(i)++;
-            tests_tmp.push_back(Z);
-            i = 0;
-        }
-        else {
-            Z(i) = -int_range;
-            i++;
+    size_t n = tests.size();
+    std::vector<Eigen::Matrix<T, 3, 1> > S_uv(n), S_u(n), S_v(n), S_none(n);
+    double uv_time = timePartialOutput<ComputeUV>(tests, S_uv);
+    double u_time = timePartialOutput<ComputeU>(tests, S_u);
+    double v_time = timePartialOutput<ComputeV>(tests, S_v);
+    double none_time = timePartialOutput<ComputeSingularValuesOnly>(tests, S_none);
+    T max_diff = 0;
+    for (size_t i = 0; i < n; i++)
+        max_diff = std::max({ max_diff, (S_u[i] - S_uv[i]).cwiseAbs().maxCoeff(), (S_v[i] - S_uv[i]).cwiseAbs().maxCoeff(), (S_none[i] - S_uv[i]).cwiseAbs().maxCoeff() });
+    std::cout << std::setprecision(4) << "ComputeUV time: " << uv_time << std::endl;
+    std::cout << std::setprecision(4) << "ComputeU time: " << u_time << ", saving: " << 100 * (1 - u_time / uv_time) << "%" << std::endl;
+    std::cout << std::setprecision(4) << "ComputeV time: " << v_time << ", saving: " << 100 * (1 - v_time / uv_time) << "%" << std::endl;
+    std::cout << std::setprecision(4) << "ComputeSingularValuesOnly time: " << none_time << ", saving: " << 100 * (1 - none_time / uv_time) << "%" << std::endl;
+    std::cout << std::setprecision(4) << "max sigma difference to ComputeUV: " << max_diff << std::endl;
+}
+
+/**
+   Slowly rotating and stretching deformation gradients F(t) = R0 R(t) diag(stretch(t)) Q(t)',
+   R0 is a random initial orientation of each element
+*/
+template <class T>
+struct RotatingBody {
+    std::vector<Eigen::Matrix<T, 3, 3> > R0;
+    std::vector<Eigen::Matrix<T, 3, 1> > axis_R, axis_Q, stretch;
+    T angular_velocity;
+
+    RotatingBody(const int number_of_elements, const T angular_velocity)
+        : R0(number_of_elements)
+        , axis_R(number_of_elements)
+        , axis_Q(number_of_elements)
+        , stretch(number_of_elements)
+        , angular_velocity(angular_velocity)
+    {
+        JIXIE::RandomNumber<T> random_gen(123);
+        for (int e = 0; e < number_of_elements; e++) {
+            Eigen::Matrix<T, 3, 1> axis_0;
+            random_gen.fill(axis_0, -1, 1);
+            random_gen.fill(axis_R[e], -1, 1);
+            random_gen.fill(axis_Q[e], -1, 1);
+            random_gen.fill(stretch[e], (T)0.5, (T)2);
+            R0[e] = Eigen::AngleAxis<T>(random_gen.randReal(0, (T)M_PI), axis_0.normalized()).toRotationMatrix();
+            axis_R[e].normalize();
+            axis_Q[e].normalize();
         }
     }
-    std::cout << std::setprecision(10) << "Adding perturbed integer test cases with perturbation " << perturb << " and range " << -int_range << " to " << int_range << std::endl;
-    RandomNumber<T> random_gen(123);
-    size_t special_cases = tests_tmp.size();
-    for (size_t t = 0; t < special_cases; t++) {
-        for (int i = 0; i < num_perturbations; i++) {
-            random_gen.fill(Z, -perturb, perturb);
-            tests.push_back(tests_tmp[t] + Z);
+
+    Eigen::Matrix<T, 3, 3> F(int e, int step) const
+    {
+        T t = step * angular_velocity;
+        Eigen::Matrix<T, 3, 1> s = stretch[e] * (1 + (T)0.2 * std::sin(t));
+        Eigen::Matrix<T, 3, 3> R = Eigen::AngleAxis<T>(t, axis_R[e]).toRotationMatrix();
+        Eigen::Matrix<T, 3, 3> Q = Eigen::AngleAxis<T>((T)0.5 * t, axis_Q[e]).toRotationMatrix();
+        return Eigen::Matrix<T, 3, 3>(R0[e] * R * s.asDiagonal() * Q.transpose());
+    }
+};
+
+/**
+   Rotating body decomposed once from scratch and once warm started from the previous step.
+*/
+template <class T>
+void runWarmStartBenchmark(const int number_of_elements, const int number_of_steps, const T angular_velocity)
+{
+    using namespace JIXIE;
+    std::cout << " \n========== RUNNING WARM START BENCHMARK == " << number_of_elements << " elements, " << number_of_steps
+              << " steps, angular velocity " << angular_velocity << " =======" << std::endl;
+    RotatingBody<T> body(number_of_elements, angular_velocity);
+    std::vector<Eigen::Matrix<T, 3, 3> > tests(number_of_elements);
+    std::vector<Eigen::Matrix<T, 3, 3> > U_cold(number_of_elements), V_cold(number_of_elements);
+    std::vector<Eigen::Matrix<T, 3, 3> > U_warm(number_of_elements), V_warm(number_of_elements);
+    std::vector<Eigen::Matrix<T, 3, 1> > sigma(number_of_elements);
+    for (int e = 0; e < number_of_elements; e++) {
+        singularValueDecomposition(body.F(e, 0), U_warm[e], sigma[e], V_warm[e]);
+    }
+
+    JIXIE::Timer timer;
+    double cold_time = 0, warm_time = 0;
+    long cold_iterations = 0, warm_sweeps = 0;
+    T max_error = 0;
+    for (int step = 1; step <= number_of_steps; step++) {
+        for (int e = 0; e < number_of_elements; e++)
+            tests[e] = body.F(e, step);
+        timer.start();
+        for (int e = 0; e < number_of_elements; e++)
+            cold_iterations += singularValueDecomposition(tests[e], U_cold[e], sigma[e], V_cold[e]);
+        cold_time += timer.click();
+        for (int e = 0; e < number_of_elements; e++)
+            warm_sweeps += singularValueDecomposition(tests[e], U_warm[e], V_warm[e], U_warm[e], sigma[e], V_warm[e]);
+        warm_time += timer.click();
+        for (int e = 0; e < number_of_elements; e++)
+            max_error = std::max(max_error, (U_warm[e] * sigma[e].asDiagonal() * V_warm[e].transpose() - tests[e]).array().abs().maxCoeff());
+    }
+    double calls = (double)number_of_elements * number_of_steps;
+    std::cout << std::setprecision(4) << "cold: " << cold_iterations / calls << " QR iterations per matrix, " << cold_time << " s" << std::endl;
+    std::cout << std::setprecision(4) << "warm: " << warm_sweeps / calls << " Jacobi sweeps per matrix, " << warm_time << " s"
+              << ", speedup: " << cold_time / warm_time << "x, recons max error: " << max_error << std::endl;
+}
+
+/**
+   Rotating body through the warm started polar decomposition of a PolarRotationStore. The cold start runs the
+   same iteration from the identity every step, the SVD polar is the reference time.
+*/
+template <class T>
+void runWarmPolarBenchmark(const int number_of_elements, const int number_of_steps, const T angular_velocity)
+{
+    using namespace JIXIE;
+    std::cout << " \n========== RUNNING WARM POLAR BENCHMARK == " << number_of_elements << " elements, " << number_of_steps
+              << " steps, angular velocity " << angular_velocity << " =======" << std::endl;
+    RotatingBody<T> body(number_of_elements, angular_velocity);
+    std::vector<Eigen::Matrix<T, 3, 3> > tests(number_of_elements), R(number_of_elements), S(number_of_elements);
+    PolarRotationStore<T> cold(number_of_elements), warm(number_of_elements);
+    ThreadPool pool;
+    for (int e = 0; e < number_of_elements; e++)
+        tests[e] = body.F(e, 0);
+    parallelPolarDecomposition(pool, warm, number_of_elements, tests.data(), S.data());
+
+    JIXIE::Timer timer;
+    double svd_time = 0, cold_time = 0, warm_time = 0;
+    long cold_sweeps = 0, warm_sweeps = 0;
+    T max_error = 0, max_orthogonality = 0;
+    for (int step = 1; step <= number_of_steps; step++) {
+        for (int e = 0; e < number_of_elements; e++)
+            tests[e] = body.F(e, step);
+        cold.reset();
+        timer.start();
+        parallelPolarDecomposition(pool, number_of_elements, tests.data(), R.data(), S.data());
+        svd_time += timer.click();
+        cold_sweeps += parallelPolarDecomposition(pool, cold, number_of_elements, tests.data(), S.data());
+        cold_time += timer.click();
+        warm_sweeps += parallelPolarDecomposition(pool, warm, number_of_elements, tests.data(), S.data());
+        warm_time += timer.click();
+        for (int e = 0; e < number_of_elements; e++) {
+            const Eigen::Matrix<T, 3, 3>& Q = warm.rotation(e);
+            max_error = std::max(max_error, (Q * S[e] - tests[e]).array().abs().maxCoeff());
+            max_orthogonality = std::max(max_orthogonality, (Q.transpose() * Q - Eigen::Matrix<T, 3, 3>::Identity()).array().abs().maxCoeff());
         }
     }
-    std::cout << std::setprecision(10) << tests.size() - old_count << " cases added." << std::endl;
-    std::cout << std::setprecision(10) << "Total test cases: " << tests.size() << std::endl;
+    double calls = (double)number_of_elements * number_of_steps;
+    std::cout << std::setprecision(4) << "svd polar: " << svd_time << " s" << std::endl;
+    std::cout << std::setprecision(4) << "cold: " << cold_sweeps / calls << " sweeps per matrix, " << cold_time << " s" << std::endl;
+    std::cout << std::setprecision(4) << "warm: " << warm_sweeps / calls << " sweeps per matrix, " << warm_time << " s"
+              << ", sweeps saved: " << 100 * (1 - (double)warm_sweeps / cold_sweeps) << "%"
+              << ", speedup over cold: " << cold_time / warm_time << "x, over svd polar: " << svd_time / warm_time << "x" << std::endl;
+    std::cout << std::setprecision(4) << "recons max error: " << max_error << ", max |R'R - I|: " << max_orthogonality << std::endl;
+}
+
+/**
+   Print what SVDStatistics.h collected since the last call, if it is compiled in
+*/
+void printStatistics(const std::string& name)
+{
+    if (JIXIE::STATISTICS::enabled)
+        std::cout << name << " statistics" << std::endl
+                  << JIXIE::STATISTICS::collect();
+    JIXIE::STATISTICS::reset();
+}
+
+void printThroughput(const size_t cases, const double scalar_time, const double batch_time)
+{
+    std::cout << std::setprecision(4) << "impQR throughput: " << cases / scalar_time * 1e-6 << " M matrices/s"
+              << ", batchQR throughput: " << cases / batch_time * 1e-6 << " M matrices/s"
+              << ", speedup: " << scalar_time / batch_time << "x" << std::endl;
 }
 
 void runBenchmark()
@@ -209,171 +449,73 @@ void runBenchmark()
     using std::fabs;
 
     bool run_qr;
+    bool run_quaternion_jacobi;
+    bool run_structured;
+    bool run_small_strain;
+    bool run_batch_qr;
+    bool run_parallel_scaling;
+    bool run_partial_output;
+    bool run_dispatch;
 
     bool test_float;
     bool test_double;
     bool accuracy_test;
     bool normalize_matrix;
     int number_of_repeated_experiments;
-    bool test_random;
-    int random_range;
-    int number_of_random_cases;
-    bool test_integer;
-    int integer_range;
-    bool test_perturbation;
-    int perturbation_count;
-    float float_perturbation;
-    double double_perturbation;
-    bool test_perturbation_from_identity;
-    int perturbation_from_identity_count;
-    float float_perturbation_identity;
-    double double_perturbation_identity;
+    std::string family;
     std::string title;
 
     // Finalized options
     run_qr = true;
+    run_quaternion_jacobi = true;
+    run_structured = true;
+    run_small_strain = true;
+    run_batch_qr = true;
+    run_parallel_scaling = true;
+    run_partial_output = true;
+    run_dispatch = true;
 
     test_float = true;
     test_double = true;
     normalize_matrix = false;
     int number_of_repeated_experiments_for_timing = 2;
 
-    for (int test_number = 1; test_number <= 10; test_number++) {
+    // Tests 1 to 5 time these families, tests 6 to 10 check their accuracy
+    const JIXIE::CaseParameters parameters;
+    const char* families[] = { "random", "integer", "integer_perturbation:256eps", "identity_perturbation:1e-3", "identity_perturbation:256eps" };
 
-        if (test_number == 1) {
-            title = "random timing test";
-            number_of_repeated_experiments = number_of_repeated_experiments_for_timing;
-            accuracy_test = false;
-            test_random = true, random_range = 3, number_of_random_cases = 1024 * 1024; // random test
-            test_integer = false; // integer test
-            integer_range = 2; // this variable is used by both integer test and perturbed integer test
-            test_perturbation = false, integer_range = 3, perturbation_count = 4, float_perturbation = (float)256 * std::numeric_limits<float>::epsilon(), double_perturbation = (double)256 * std::numeric_limits<double>::epsilon(); // perturbed integer test
-            test_perturbation_from_identity = false, perturbation_from_identity_count = 1024 * 1024, float_perturbation_identity = 1e-3, double_perturbation_identity = 1e-3; // perturbed itentity test
-        }
-        if (test_number == 2) {
-            title = "integer timing test";
-            number_of_repeated_experiments = number_of_repeated_experiments_for_timing;
-            accuracy_test = false;
-            test_random = false, random_range = 3, number_of_random_cases = 1024 * 1024; // random test
-            test_integer = true; // integer test
-            integer_range = 2; // this variable is used by both integer test and perturbed integer test
-            test_perturbation = false, perturbation_count = 4, float_perturbation = (float)256 * std::numeric_limits<float>::epsilon(), double_perturbation = (double)256 * std::numeric_limits<double>::epsilon(); // perturbed integer test
-            test_perturbation_from_identity = false, perturbation_from_identity_count = 1024 * 1024, float_perturbation_identity = 1e-3, double_perturbation_identity = 1e-3; // perturbed itentity test
-        }
-        if (test_number == 3) {
-            title = "integer-perturbation timing test: 256 eps";
-            number_of_repeated_experiments = number_of_repeated_experiments_for_timing;
-            accuracy_test = false;
-            test_random = false, random_range = 3, number_of_random_cases = 1024 * 1024; // random test
-            test_integer = false; // integer test
-            integer_range = 2; // this variable is used by both integer test and perturbed integer test
-            test_perturbation = true, perturbation_count = 4, float_perturbation = (float)256 * std::numeric_limits<float>::epsilon(), double_perturbation = (double)256 * std::numeric_limits<double>::epsilon(); // perturbed integer test
-            test_perturbation_from_identity = false, perturbation_from_identity_count = 1024 * 1024, float_perturbation_identity = 1e-3, double_perturbation_identity = 1e-3; // perturbed itentity test
-        }
-        if (test_number == 4) {
-            title = "identity-perturbation timing test: 1e-3";
-            number_of_repeated_experiments = number_of_repeated_experiments_for_timing;
-            accuracy_test = false;
-            test_random = false, random_range = 3, number_of_random_cases = 1024 * 1024; // random test
-            test_integer = false; // integer test
-            integer_range = 2; // this variable is used by both integer test and perturbed integer test
-            test_perturbation = false, perturbation_count = 4, float_perturbation = (float)256 * std::numeric_limits<float>::epsilon(), double_perturbation = (double)256 * std::numeric_limits<double>::epsilon(); // perturbed integer test
-            test_perturbation_from_identity = true, perturbation_from_identity_count = 1024 * 1024, float_perturbation_identity = 1e-3, double_perturbation_identity = 1e-3; // perturbed itentity test
-        }
-        if (test_number == 5) {
-            title = "identity-perturbation timing test: 256 eps";
-            number_of_repeated_experiments = number_of_repeated_experiments_for_timing;
-            accuracy_test = false;
-            test_random = false, random_range = 3, number_of_random_cases = 1024 * 1024; // random test
-            test_integer = false; // integer test
-            integer_range = 2; // this variable is used by both integer test and perturbed integer test
-            test_perturbation = false, perturbation_count = 4, float_perturbation = (float)256 * std::numeric_limits<float>::epsilon(), double_perturbation = (double)256 * std::numeric_limits<double>::epsilon(); // perturbed integer test
-            test_perturbation_from_identity = true, perturbation_from_identity_count = 1024 * 1024, float_perturbation_identity = (float)256 * std::numeric_limits<float>::epsilon(), double_perturbation_identity = (double)256 * std::numeric_limits<double>::epsilon(); // perturbed itentity test
-        }
+    for (int test_number = 1; test_number <= 10; test_number++) {
 
-        if (test_number == 6) {
-            title = "random accuracy test";
-            number_of_repeated_experiments = 1;
-            accuracy_test = true;
-            test_random = true, random_range = 3, number_of_random_cases = 1024 * 1024; // random test
-            test_integer = false; // integer test
-            integer_range = 2; // this variable is used by both integer test and perturbed integer test
-            test_perturbation = false, integer_range = 3, perturbation_count = 4, float_perturbation = (float)256 * std::numeric_limits<float>::epsilon(), double_perturbation = (double)256 * std::numeric_limits<double>::epsilon(); // perturbed integer test
-            test_perturbation_from_identity = false, perturbation_from_identity_count = 1024 * 1024, float_perturbation_identity = 1e-3, double_perturbation_identity = 1e-3; // perturbed itentity test
-        }
-        if (test_number == 7) {
-            title = "integer accuracy test";
-            number_of_repeated_experiments = 1;
-            accuracy_test = true;
-            test_random = false, random_range = 3, number_of_random_cases = 1024 * 1024; // random test
-            test_integer = true; // integer test
-            integer_range = 2; // this variable is used by both integer test and perturbed integer test
-            test_perturbation = false, perturbation_count = 4, float_perturbation = (float)256 * std::numeric_limits<float>::epsilon(), double_perturbation = (double)256 * std::numeric_limits<double>::epsilon(); // perturbed integer test
-            test_perturbation_from_identity = false, perturbation_from_identity_count = 1024 * 1024, float_perturbation_identity = 1e-3, double_perturbation_identity = 1e-3; // perturbed itentity test
-        }
-        if (test_number == 8) {
-            title = "integer-perturbation accuracy test: 256 eps";
-            number_of_repeated_experiments = 1;
-            accuracy_test = true;
-            test_random = false, random_range = 3, number_of_random_cases = 1024 * 1024; // random test
-            test_integer = false; // integer test
-            integer_range = 2; // this variable is used by both integer test and perturbed integer test
-            test_perturbation = true, perturbation_count = 4, float_perturbation = (float)256 * std::numeric_limits<float>::epsilon(), double_perturbation = (double)256 * std::numeric_limits<double>::epsilon(); // perturbed integer test
-            test_perturbation_from_identity = false, perturbation_from_identity_count = 1024 * 1024, float_perturbation_identity = 1e-3, double_perturbation_identity = 1e-3; // perturbed itentity test
-        }
-        if (test_number == 9) {
-            title = "identity-perturbation accuracy test: 1e-3";
-            number_of_repeated_experiments = 1;
-            accuracy_test = true;
-            test_random = false, random_range = 3, number_of_random_cases = 1024 * 1024; // random test
-            test_integer = false; // integer test
-            integer_range = 2; // this variable is used by both integer test and perturbed integer test
-            test_perturbation = false, perturbation_count = 4, float_perturbation = (float)256 * std::numeric_limits<float>::epsilon(), double_perturbation = (double)256 * std::numeric_limits<double>::epsilon(); // perturbed integer test
-            test_perturbation_from_identity = true, perturbation_from_identity_count = 1024 * 1024, float_perturbation_identity = 1e-3, double_perturbation_identity = 1e-3; // perturbed itentity test
-        }
-        if (test_number == 10) {
-            title = "identity-perturbation accuracy test: 256 eps";
-            number_of_repeated_experiments = 1;
-            accuracy_test = true;
-            test_random = false, random_range = 3, number_of_random_cases = 1024 * 1024; // random test
-            test_integer = false; // integer test
-            integer_range = 2; // this variable is used by both integer test and perturbed integer test
-            test_perturbation = false, perturbation_count = 4, float_perturbation = (float)256 * std::numeric_limits<float>::epsilon(), double_perturbation = (double)256 * std::numeric_limits<double>::epsilon(); // perturbed integer test
-            test_perturbation_from_identity = true, perturbation_from_identity_count = 1024 * 1024, float_perturbation_identity = (float)256 * std::numeric_limits<float>::epsilon(), double_perturbation_identity = (double)256 * std::numeric_limits<double>::epsilon(); // perturbed itentity test
-        }
+        accuracy_test = test_number > 5;
+        family = families[(test_number - 1) % 5];
+        title = family + (accuracy_test ? " accuracy test" : " timing test");
+        number_of_repeated_experiments = accuracy_test ? 1 : number_of_repeated_experiments_for_timing;
 
         std::cout << " \n========== RUNNING BENCHMARK TEST == " << title << "=======" << std::endl;
         std::cout << " run_qr " << run_qr << std::endl;
+        std::cout << " run_quaternion_jacobi " << run_quaternion_jacobi << std::endl;
+        std::cout << " run_structured " << run_structured << std::endl;
+        std::cout << " run_small_strain " << run_small_strain << std::endl;
+        std::cout << " run_batch_qr " << run_batch_qr << std::endl;
+        std::cout << " run_parallel_scaling " << run_parallel_scaling << std::endl;
+        std::cout << " run_partial_output " << run_partial_output << std::endl;
+        std::cout << " run_dispatch " << run_dispatch << std::endl;
         std::cout << " test_float " << test_float << std::endl;
         std::cout << " test_double " << test_double << std::endl;
         std::cout << " accuracy_test " << accuracy_test << std::endl;
         std::cout << " normalize_matrix " << normalize_matrix << std::endl;
         std::cout << " number_of_repeated_experiments " << number_of_repeated_experiments << std::endl;
-        std::cout << " test_random " << test_random << std::endl;
-        std::cout << " random_range " << random_range << std::endl;
-        std::cout << " number_of_random_cases " << number_of_random_cases << std::endl;
-        std::cout << " test_integer " << test_integer << std::endl;
-        std::cout << " integer_range " << integer_range << std::endl;
-        std::cout << " test_perturbation " << test_perturbation << std::endl;
-        std::cout << " perturbation_count " << perturbation_count << std::endl;
-        std::cout << " float_perturbation " << float_perturbation << std::endl;
-        std::cout << " double_perturbation " << double_perturbation << std::endl;
-        std::cout << " test_perturbation_from_identity " << test_perturbation_from_identity << std::endl;
-        std::cout << " perturbation_from_identity_count " << perturbation_from_identity_count << std::endl;
-        std::cout << " float_perturbation_identity " << float_perturbation_identity << std::endl;
-        std::cout << " double_perturbation_identity " << double_perturbation_identity << std::endl;
+        std::cout << " family " << family << std::endl;
+        std::cout << " random_range " << parameters.random_range << std::endl;
+        std::cout << " random_count " << parameters.random_count << std::endl;
+        std::cout << " integer_range " << parameters.integer_range << std::endl;
+        std::cout << " perturbation_count " << parameters.perturbation_count << std::endl;
+        std::cout << " identity_count " << parameters.identity_count << std::endl;
 
         std::cout << std::setprecision(10) << "\n--- float test ---\n" << std::endl;
         if (test_float) {
             std::vector<Eigen::Matrix<float, 3, 3> > tests;
-            if (test_integer)
-                addIntegerCases(tests, integer_range);
-            if (test_perturbation)
-                addPerturbationCases(tests, integer_range, perturbation_count, float_perturbation);
-            if (test_perturbation_from_identity)
-                addPerturbationFromIdentityCases(tests, perturbation_from_identity_count, float_perturbation_identity);
-            if (test_random)
-                addRandomCases(tests, (float)random_range, number_of_random_cases);
+            addCases(tests, family, parameters);
             if (normalize_matrix) {
                 for (size_t i = 0; i < tests.size(); i++) {
                     float norm = tests[i].norm();
@@ -383,22 +525,46 @@ void runBenchmark()
                 }
             }
             std::cout << std::setprecision(10) << "\n-----------" << std::endl;
-            if (run_qr)
-                runImplicitQRSVD(number_of_repeated_experiments, tests, accuracy_test);
-
+            double qr_time = 0, jacobi_time = 0, structured_time = 0, small_strain_time = 0, batch_qr_time = 0;
+            JIXIE::STATISTICS::reset();
+            if (run_qr) {
+                qr_time = runSVD<ImplicitQR>("impQR", number_of_repeated_experiments, tests, accuracy_test);
+                printStatistics("impQR");
+            }
+            if (run_quaternion_jacobi)
+                jacobi_time = runSVD<QuaternionJacobi>("qJacobi", number_of_repeated_experiments, tests, accuracy_test);
+            if (run_qr && run_quaternion_jacobi)
+                std::cout << std::setprecision(4) << "qJacobi speedup over impQR: " << qr_time / jacobi_time << "x" << std::endl;
+            if (run_structured) {
+                JIXIE::STATISTICS::reset();
+                structured_time = runSVD<Structured>("structured", number_of_repeated_experiments, tests, accuracy_test);
+                printStatistics("structured");
+            }
+            if (run_qr && run_structured)
+                std::cout << std::setprecision(4) << "structured speedup over impQR: " << qr_time / structured_time << "x" << std::endl;
+            if (run_small_strain)
+                small_strain_time = runSVD<SmallStrain>("smallStrain", number_of_repeated_experiments, tests, accuracy_test);
+            if (run_qr && run_small_strain)
+                std::cout << std::setprecision(4) << "smallStrain speedup over impQR: " << qr_time / small_strain_time << "x" << std::endl;
+            if (run_batch_qr) {
+                JIXIE::STATISTICS::reset();
+                batch_qr_time = runBatchedImplicitQRSVD(number_of_repeated_experiments, tests, accuracy_test);
+                printStatistics("batchQR");
+            }
+            if (run_qr && run_batch_qr)
+                printThroughput(tests.size(), qr_time, batch_qr_time);
+            if (run_parallel_scaling && !accuracy_test)
+                runParallelScaling(tests);
+            if (run_partial_output && !accuracy_test)
+                runPartialOutputBenchmark(tests);
+            if (run_dispatch && !accuracy_test)
+                runDispatchBenchmark(tests);
         }
 
         std::cout << std::setprecision(10) << "\n--- double test ---\n" << std::endl;
         if (test_double) {
             std::vector<Eigen::Matrix<double, 3, 3> > tests;
-            if (test_integer)
-                addIntegerCases(tests, integer_range);
-            if (test_perturbation)
-                addPerturbationCases(tests, integer_range, perturbation_count, double_perturbation);
-            if (test_perturbation_from_identity)
-                addPerturbationFromIdentityCases(tests, perturbation_from_identity_count, double_perturbation_identity);
-            if (test_random)
-                addRandomCases(tests, (double)random_range, number_of_random_cases);
+            addCases(tests, family, parameters);
             if (normalize_matrix) {
                 for (size_t i = 0; i < tests.size(); i++) {
                     double norm = tests[i].norm();
@@ -408,11 +574,927 @@ void runBenchmark()
                 }
             }
             std::cout << std::setprecision(10) << "\n-----------" << std::endl;
-            if (run_qr)
-                runImplicitQRSVD(number_of_repeated_experiments, tests, accuracy_test);
+            double qr_time = 0, jacobi_time = 0, structured_time = 0, small_strain_time = 0, batch_qr_time = 0;
+            JIXIE::STATISTICS::reset();
+            if (run_qr) {
+                qr_time = runSVD<ImplicitQR>("impQR", number_of_repeated_experiments, tests, accuracy_test);
+                printStatistics("impQR");
+            }
+            if (run_quaternion_jacobi)
+                jacobi_time = runSVD<QuaternionJacobi>("qJacobi", number_of_repeated_experiments, tests, accuracy_test);
+            if (run_qr && run_quaternion_jacobi)
+                std::cout << std::setprecision(4) << "qJacobi speedup over impQR: " << qr_time / jacobi_time << "x" << std::endl;
+            if (run_structured) {
+                JIXIE::STATISTICS::reset();
+                structured_time = runSVD<Structured>("structured", number_of_repeated_experiments, tests, accuracy_test);
+                printStatistics("structured");
+            }
+            if (run_qr && run_structured)
+                std::cout << std::setprecision(4) << "structured speedup over impQR: " << qr_time / structured_time << "x" << std::endl;
+            if (run_small_strain)
+                small_strain_time = runSVD<SmallStrain>("smallStrain", number_of_repeated_experiments, tests, accuracy_test);
+            if (run_qr && run_small_strain)
+                std::cout << std::setprecision(4) << "smallStrain speedup over impQR: " << qr_time / small_strain_time << "x" << std::endl;
+            if (run_batch_qr) {
+                JIXIE::STATISTICS::reset();
+                batch_qr_time = runBatchedImplicitQRSVD(number_of_repeated_experiments, tests, accuracy_test);
+                printStatistics("batchQR");
+            }
+            if (run_qr && run_batch_qr)
+                printThroughput(tests.size(), qr_time, batch_qr_time);
+            if (run_parallel_scaling && !accuracy_test)
+                runParallelScaling(tests);
+            if (run_partial_output && !accuracy_test)
+                runPartialOutputBenchmark(tests);
+            if (run_dispatch && !accuracy_test)
+                runDispatchBenchmark(tests);
+        }
+    }
+}
+
+/**
+   Output buffers of the benchmark harness engines, allocated outside the timed region
+*/
+template <class T>
+struct HarnessBuffers {
+    std::vector<Eigen::Matrix<T, 3, 3> > U, V, R, S_Sym;
+    std::vector<JIXIE::SymmetricMatrix3<T> > S_packed;
+    std::vector<Eigen::Matrix<T, 3, 1> > sigma;
+    JIXIE::MatrixStreams<T, 3, 3> A_streams, U_streams, V_streams;
+    JIXIE::MatrixStreams<T, 3, 1> sigma_streams;
+
+    HarnessBuffers(const std::vector<Eigen::Matrix<T, 3, 3> >& tests)
+        : U(tests.size())
+        , V(tests.size())
+        , R(tests.size())
+        , S_Sym(tests.size())
+        , S_packed(tests.size())
+        , sigma(tests.size())
+        , A_streams(tests.size())
+        , U_streams(tests.size())
+        , V_streams(tests.size())
+        , sigma_streams(tests.size())
+    {
+        for (size_t i = 0; i < tests.size(); i++)
+            A_streams.set(i, tests[i]);
+    }
+};
+
+/**
+   One pass of the named engine over all the tests: impQR, qJacobi, structured, smallStrain, batchQR, polar, polarPacked,
+   smallStrainPolar or dispatch
+*/
+template <class T>
+std::function<void(JIXIE::ThreadPool&)> harnessEngine(const std::string& name, const std::vector<Eigen::Matrix<T, 3, 3> >& tests, HarnessBuffers<T>& b)
+{
+    using namespace JIXIE;
+    const size_t n = tests.size();
+    if (name == "impQR")
+        return [&, n](ThreadPool& pool) {
+            parallelSingularValueDecomposition(pool, n, tests.data(), b.U.data(), b.sigma.data(), b.V.data());
+        };
+    if (name == "qJacobi")
+        return [&, n](ThreadPool& pool) {
+            pool.parallelFor(n, 4096, [&](size_t begin, size_t end, int) {
+                for (size_t i = begin; i < end; i++)
+                    singularValueDecomposition<QuaternionJacobi>(tests[i], b.U[i], b.sigma[i], b.V[i]);
+            });
+        };
+    if (name == "structured")
+        return [&, n](ThreadPool& pool) {
+            pool.parallelFor(n, 4096, [&](size_t begin, size_t end, int) {
+                for (size_t i = begin; i < end; i++)
+                    singularValueDecomposition<Structured>(tests[i], b.U[i], b.sigma[i], b.V[i]);
+            });
+        };
+    if (name == "smallStrain")
+        return [&, n](ThreadPool& pool) {
+            pool.parallelFor(n, 4096, [&](size_t begin, size_t end, int) {
+                for (size_t i = begin; i < end; i++)
+                    singularValueDecomposition<SmallStrain>(tests[i], b.U[i], b.sigma[i], b.V[i]);
+            });
+        };
+    if (name == "batchQR")
+        return [&, n](ThreadPool& pool) {
+            parallelBatchSingularValueDecomposition(pool, n, b.A_streams.streams(), b.U_streams.streams(), b.sigma_streams.streams(), b.V_streams.streams());
+        };
+    if (name == "polar")
+        return [&, n](ThreadPool& pool) {
+            parallelPolarDecomposition(pool, n, tests.data(), b.R.data(), b.S_Sym.data());
+        };
+    if (name == "polarPacked")
+        return [&, n](ThreadPool& pool) {
+            parallelPolarDecomposition(pool, n, tests.data(), b.R.data(), b.S_packed.data());
+        };
+    if (name == "smallStrainPolar")
+        return [&, n](ThreadPool& pool) {
+            pool.parallelFor(n, 4096, [&](size_t begin, size_t end, int) {
+                for (size_t i = begin; i < end; i++)
+                    smallStrainPolarDecomposition(tests[i], b.R[i], b.S_Sym[i]);
+            });
+        };
+    if (name == "dispatch")
+        return [&, n](ThreadPool& pool) {
+            pool.parallelFor(n, 4096, [&](size_t begin, size_t end, int) {
+                DISPATCH::singularValueDecomposition(end - begin, tests.data() + begin, b.U.data() + begin, b.sigma.data() + begin, b.V.data() + begin);
+            });
+        };
+    throw std::invalid_argument("unknown engine " + name);
+}
+
+/**
+   Per thread buffers of one chunk for the streaming harness, along with the errors that thread found
+*/
+template <class T>
+struct ChunkBuffers {
+    std::vector<Eigen::Matrix<T, 3, 3> > A, U, V, R, S_Sym;
+    std::vector<JIXIE::SymmetricMatrix3<T> > S_packed;
+    std::vector<Eigen::Matrix<T, 3, 1> > sigma;
+    JIXIE::MatrixStreams<T, 3, 3> A_streams, U_streams, V_streams;
+    JIXIE::MatrixStreams<T, 3, 1> sigma_streams;
+    JIXIE::AccuracyErrors<T> errors;
+
+    ChunkBuffers(const size_t chunk)
+        : A(chunk)
+        , U(chunk)
+        , V(chunk)
+        , R(chunk)
+        , S_Sym(chunk)
+        , S_packed(chunk)
+        , sigma(chunk)
+        , A_streams(chunk)
+        , U_streams(chunk)
+        , V_streams(chunk)
+        , sigma_streams(chunk)
+    {
+    }
+};
+
+/**
+   The named engine on cases first to first + n - 1 of a generator, n at most the chunk size.
+   Errors go to the buffers when check is set. generate only makes the cases, to tell their cost apart.
+*/
+template <class T>
+std::function<void(const JIXIE::CaseGenerator<T>&, size_t, size_t, ChunkBuffers<T>&, bool)> chunkEngine(const std::string& name)
+{
+    using namespace JIXIE;
+    if (name == "generate")
+        return [](const CaseGenerator<T>& cases, size_t first, size_t n, ChunkBuffers<T>& b, bool) {
+            cases.fill(first, n, b.A.data());
+        };
+    if (name == "impQR" || name == "qJacobi" || name == "structured" || name == "smallStrain" || name == "dispatch") {
+        const int engine = name == "impQR" ? 0 : name == "qJacobi" ? 1 : name == "structured" ? 3 : name == "smallStrain" ? 4 : 2;
+        return [engine](const CaseGenerator<T>& cases, size_t first, size_t n, ChunkBuffers<T>& b, bool check) {
+            cases.fill(first, n, b.A.data());
+            if (engine == 2)
+                DISPATCH::singularValueDecomposition(n, b.A.data(), b.U.data(), b.sigma.data(), b.V.data());
+            for (size_t i = 0; i < n && engine != 2; i++) {
+                if (engine == 0)
+                    singularValueDecomposition(b.A[i], b.U[i], b.sigma[i], b.V[i]);
+                else if (engine == 1)
+                    singularValueDecomposition<QuaternionJacobi>(b.A[i], b.U[i], b.sigma[i], b.V[i]);
+                else if (engine == 3)
+                    singularValueDecomposition<Structured>(b.A[i], b.U[i], b.sigma[i], b.V[i]);
+                else
+                    singularValueDecomposition<SmallStrain>(b.A[i], b.U[i], b.sigma[i], b.V[i]);
+            }
+            for (size_t i = 0; i < n && check; i++)
+                b.errors.addSVD(b.A[i], b.U[i], b.sigma[i], b.V[i], first + i);
+        };
+    }
+    if (name == "batchQR")
+        return [](const CaseGenerator<T>& cases, size_t first, size_t n, ChunkBuffers<T>& b, bool check) {
+            cases.fillStreams(first, n, b.A_streams.streams());
+            batchSingularValueDecomposition(n, b.A_streams.streams(), b.U_streams.streams(), b.sigma_streams.streams(), b.V_streams.streams());
+            if (check)
+                checkSVD(b.errors, n, b.A_streams.streams(), b.U_streams.streams(), b.sigma_streams.streams(), b.V_streams.streams(), first);
+        };
+    if (name == "polar")
+        return [](const CaseGenerator<T>& cases, size_t first, size_t n, ChunkBuffers<T>& b, bool check) {
+            cases.fill(first, n, b.A.data());
+            for (size_t i = 0; i < n; i++)
+                polarDecomposition(b.A[i], b.R[i], b.S_Sym[i]);
+            for (size_t i = 0; i < n && check; i++)
+                b.errors.addPolar(b.A[i], b.R[i], b.S_Sym[i], first + i);
+        };
+    if (name == "polarPacked")
+        return [](const CaseGenerator<T>& cases, size_t first, size_t n, ChunkBuffers<T>& b, bool check) {
+            cases.fill(first, n, b.A.data());
+            for (size_t i = 0; i < n; i++)
+                polarDecomposition(b.A[i], b.R[i], b.S_packed[i]);
+            for (size_t i = 0; i < n && check; i++)
+                b.errors.addPolar(b.A[i], b.R[i], b.S_packed[i], first + i);
+        };
+    if (name == "smallStrainPolar")
+        return [](const CaseGenerator<T>& cases, size_t first, size_t n, ChunkBuffers<T>& b, bool check) {
+            cases.fill(first, n, b.A.data());
+            for (size_t i = 0; i < n; i++)
+                smallStrainPolarDecomposition(b.A[i], b.R[i], b.S_Sym[i]);
+            for (size_t i = 0; i < n && check; i++)
+                b.errors.addPolar(b.A[i], b.R[i], b.S_Sym[i], first + i);
+        };
+    throw std::invalid_argument("unknown streaming engine " + name);
+}
+
+/**
+   The named engine on one matrix, returning its QR iterations, or Jacobi sweeps for qJacobi, symmetric input to structured
+   and smallStrain short of its fallback. batchQR decomposes a SIMD pack of copies of the matrix, so its latency is that of one pack.
+   dispatch and the polar engines report the iterations of the implicit QR SVD, counted outside the timed call.
+*/
+template <class T>
+std::function<int(const Eigen::Matrix<T, 3, 3>&, ChunkBuffers<T>&)> singleEngine(const std::string& name)
+{
+    using namespace JIXIE;
+    typedef Eigen::Matrix<T, 3, 3> Matrix;
+    if (name == "impQR")
+        return [](const Matrix& A, ChunkBuffers<T>& b) { return singularValueDecomposition(A, b.U[0], b.sigma[0], b.V[0]); };
+    if (name == "qJacobi")
+        return [](const Matrix& A, ChunkBuffers<T>& b) { return singularValueDecomposition<QuaternionJacobi>(A, b.U[0], b.sigma[0], b.V[0]); };
+    if (name == "structured")
+        return [](const Matrix& A, ChunkBuffers<T>& b) { return singularValueDecomposition<Structured>(A, b.U[0], b.sigma[0], b.V[0]); };
+    if (name == "smallStrain")
+        return [](const Matrix& A, ChunkBuffers<T>& b) { return singularValueDecomposition<SmallStrain>(A, b.U[0], b.sigma[0], b.V[0]); };
+    if (name == "batchQR")
+        return [](const Matrix& A, ChunkBuffers<T>& b) {
+            const size_t width = b.A_streams.size();
+            for (size_t l = 0; l < width; l++)
+                b.A_streams.set(l, A);
+            int count[SIMD::NativeWidth<T>::value];
+            batchSingularValueDecomposition(width, b.A_streams.streams(), b.U_streams.streams(), b.sigma_streams.streams(), b.V_streams.streams(), count);
+            return count[0];
+        };
+    if (name == "dispatch")
+        return [](const Matrix& A, ChunkBuffers<T>& b) {
+            DISPATCH::singularValueDecomposition(1, &A, b.U.data(), b.sigma.data(), b.V.data());
+            return -1;
+        };
+    if (name == "polar")
+        return [](const Matrix& A, ChunkBuffers<T>& b) {
+            polarDecomposition(A, b.R[0], b.S_Sym[0]);
+            return -1;
+        };
+    if (name == "polarPacked")
+        return [](const Matrix& A, ChunkBuffers<T>& b) {
+            polarDecomposition(A, b.R[0], b.S_packed[0]);
+            return -1;
+        };
+    if (name == "smallStrainPolar")
+        return [](const Matrix& A, ChunkBuffers<T>& b) {
+            smallStrainPolarDecomposition(A, b.R[0], b.S_Sym[0]);
+            return -1;
+        };
+    throw std::invalid_argument("no single matrix latency for engine " + name);
+}
 
+/**
+   Latencies in ns and iteration counts of single decompositions
+*/
+struct LatencyProfile {
+    std::vector<double> ns;
+    std::vector<double> iterations;
+};
+
+/**
+   Times samples cases, spread evenly over the first n, one decomposition at a time on the
+   calling thread with the CycleTimer. The cost of an empty timed region is subtracted.
+*/
+template <class T>
+LatencyProfile measureLatency(const std::string& engine, const std::function<Eigen::Matrix<T, 3, 3>(size_t)>& get, const size_t n, size_t samples)
+{
+    using JIXIE::CycleTimer;
+    auto run = singleEngine<T>(engine);
+    ChunkBuffers<T> b(JIXIE::SIMD::NativeWidth<T>::value);
+    const int64_t overhead = CycleTimer::overhead();
+    samples = std::min(samples, n);
+    LatencyProfile profile;
+    for (size_t j = 0; j < std::min<size_t>(samples, 64); j++)
+        run(get(j * n / samples), b);
+    for (size_t j = 0; j < samples; j++) {
+        Eigen::Matrix<T, 3, 3> A = get(j * n / samples);
+        uint64_t begin = CycleTimer::start();
+        int iterations = run(A, b);
+        int64_t ticks = (int64_t)(CycleTimer::stop() - begin) - overhead;
+        if (iterations < 0)
+            iterations = JIXIE::singularValueDecomposition(A, b.U[0], b.sigma[0], b.V[0]);
+        profile.ns.push_back(CycleTimer::nanoseconds(std::max<int64_t>(ticks, 0)));
+        profile.iterations.push_back(iterations);
+    }
+    return profile;
+}
+
+/**
+   Iteration and latency percentiles of a LatencyProfile as columns of a report row,
+   along with the rank correlation of latency and iterations and the share of latencies over budget_ns
+*/
+void setLatencyColumns(JIXIE::BENCHMARK::Report::Row& row, const LatencyProfile& profile, const double budget_ns)
+{
+    // NaN for engines without a profile, so that every row has the same columns
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    auto percentile = [&](const std::vector<double>& x, const double q) {
+        return x.empty() ? nan : JIXIE::BENCHMARK::percentile(x, q);
+    };
+    // ranks with ties averaged, so that a few interrupted samples do not decide the correlation
+    auto ranks = [](const std::vector<double>& x) {
+        std::vector<size_t> order(x.size());
+        for (size_t j = 0; j < x.size(); j++)
+            order[j] = j;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return x[a] < x[b]; });
+        std::vector<double> rank(x.size());
+        for (size_t begin = 0, end; begin < x.size(); begin = end) {
+            for (end = begin + 1; end < x.size() && x[order[end]] == x[order[begin]]; end++)
+                ;
+            for (size_t j = begin; j < end; j++)
+                rank[order[j]] = (begin + end - 1) / 2.0;
         }
+        return rank;
+    };
+    const size_t n = profile.ns.size();
+    std::vector<double> rank_i = ranks(profile.iterations), rank_t = ranks(profile.ns);
+    double sum_i = 0, over = 0;
+    for (size_t j = 0; j < n; j++) {
+        sum_i += profile.iterations[j];
+        over += profile.ns[j] > budget_ns;
+    }
+    const double mean_rank = (n - 1) / 2.0;
+    double cov = 0, var_i = 0, var_t = 0;
+    for (size_t j = 0; j < n; j++) {
+        cov += (rank_i[j] - mean_rank) * (rank_t[j] - mean_rank);
+        var_i += (rank_i[j] - mean_rank) * (rank_i[j] - mean_rank);
+        var_t += (rank_t[j] - mean_rank) * (rank_t[j] - mean_rank);
     }
+    row.set("latency_samples", n)
+        .set("iterations_ave", n ? sum_i / n : nan)
+        .set("iterations_p99", percentile(profile.iterations, 0.99))
+        .set("iterations_max", percentile(profile.iterations, 1))
+        .set("latency_p50_ns", percentile(profile.ns, 0.5))
+        .set("latency_p90_ns", percentile(profile.ns, 0.9))
+        .set("latency_p99_ns", percentile(profile.ns, 0.99))
+        .set("latency_p999_ns", percentile(profile.ns, 0.999))
+        .set("latency_max_ns", percentile(profile.ns, 1))
+        .set("latency_iterations_rho", var_i > 0 && var_t > 0 ? cov / std::sqrt(var_i * var_t) : nan);
+    if (budget_ns > 0)
+        row.set("over_budget", n ? over / n : nan);
+}
+
+/**
+   Hardware events of one pass over n matrices on the calling thread, see PerfCounters
+*/
+struct CounterProfile {
+    double matrices = 0;
+    double seconds = 0;
+    double count[JIXIE::PerfCounters::EventCount];
+    double flops = 0;
+};
+
+CounterProfile countPass(const size_t n, const std::function<void()>& pass)
+{
+    using JIXIE::PerfCounters;
+    PerfCounters counters;
+    JIXIE::Timer timer;
+    counters.start();
+    timer.start();
+    pass();
+    double seconds = timer.click();
+    counters.stop();
+    CounterProfile profile;
+    profile.matrices = (double)n;
+    profile.seconds = seconds;
+    for (int e = 0; e < PerfCounters::EventCount; e++)
+        profile.count[e] = counters.count((PerfCounters::Event)e);
+    profile.flops = counters.flops();
+    return profile;
+}
+
+/**
+   Per matrix event counts, IPC and GFLOP/s of a CounterProfile as columns of a report row, NaN where the host has no such event
+*/
+void setCounterColumns(JIXIE::BENCHMARK::Report::Row& row, const CounterProfile& profile)
+{
+    using JIXIE::PerfCounters;
+    row.set("cycles_per_matrix", profile.count[PerfCounters::Cycles] / profile.matrices)
+        .set("instructions_per_matrix", profile.count[PerfCounters::Instructions] / profile.matrices)
+        .set("ipc", profile.count[PerfCounters::Instructions] / profile.count[PerfCounters::Cycles])
+        .set("branch_misses_per_matrix", profile.count[PerfCounters::BranchMisses] / profile.matrices)
+        .set("l1d_misses_per_matrix", profile.count[PerfCounters::L1DMisses] / profile.matrices)
+        .set("llc_misses_per_matrix", profile.count[PerfCounters::LLCMisses] / profile.matrices)
+        .set("flops_per_matrix", profile.flops / profile.matrices)
+        .set("gflops", profile.flops / profile.seconds * 1e-9);
+}
+
+/**
+   Quarter octave histogram of the latencies of a LatencyProfile, empty buckets left out, then the
+   latency percentiles for each iteration count
+*/
+void printLatencyProfile(std::ostream& out, const std::string& title, const LatencyProfile& profile)
+{
+    using JIXIE::BENCHMARK::percentile;
+    if (profile.ns.empty())
+        return;
+    out << title << ": latency of " << profile.ns.size() << " single decompositions\n";
+    std::map<int, size_t> buckets;
+    for (double ns : profile.ns)
+        buckets[(int)std::floor(4 * std::log2(std::max(ns, 1.0)))]++;
+    size_t most = 0, cumulative = 0;
+    for (auto& b : buckets)
+        most = std::max(most, b.second);
+    for (auto& b : buckets) {
+        cumulative += b.second;
+        out << std::setw(10) << std::fixed << std::setprecision(0) << std::exp2(b.first / 4.0) << " ns " << std::setw(9) << b.second
+            << std::setw(9) << std::setprecision(4) << 100.0 * cumulative / profile.ns.size() << "% "
+            << std::string(std::max<size_t>(1, 50 * b.second / most), '#') << "\n";
+    }
+    std::map<int, std::vector<double> > by_iterations;
+    for (size_t j = 0; j < profile.ns.size(); j++)
+        by_iterations[(int)profile.iterations[j]].push_back(profile.ns[j]);
+    out << std::setw(11) << "iterations" << std::setw(10) << "count" << std::setw(9) << "share" << std::setw(10) << "p50_ns" << std::setw(10) << "p99_ns" << std::setw(10) << "max_ns"
+        << "\n";
+    for (auto& i : by_iterations)
+        out << std::setw(11) << i.first << std::setw(10) << i.second.size() << std::setw(8) << std::setprecision(3) << 100.0 * i.second.size() / profile.ns.size() << "%"
+            << std::setw(10) << std::setprecision(0) << percentile(i.second, 0.5) << std::setw(10) << percentile(i.second, 0.99) << std::setw(10) << percentile(i.second, 1) << "\n";
+    out << std::defaultfloat << std::setprecision(6) << std::flush;
+}
+
+/**
+   Everything the benchmark harness reads from its options
+*/
+struct HarnessConfig {
+    std::vector<std::string> families;
+    std::vector<std::string> engines;
+    std::vector<std::string> precisions;
+    std::vector<int> threads;
+    std::vector<size_t> sizes;
+    int warmup;
+    int repeat;
+    double outlier_threshold;
+    bool pin;
+    JIXIE::BENCHMARK::Report::Format format;
+    std::string output;
+    JIXIE::CaseParameters parameters;
+    bool stream; // generate the cases chunk by chunk inside the timed passes instead of storing them
+    size_t chunk;
+    bool accuracy;
+    bool sweep; // exhaustive integer sweep over one representative per symmetry orbit
+    int expand;
+    size_t latency; // cases timed one at a time for the latency and iteration percentiles, 0 for none
+    double budget; // ns per matrix, the share of latencies over it is reported
+    bool histogram; // print the latency histograms
+    bool counters; // count hardware events in an extra single threaded pass
+
+    HarnessConfig(const JIXIE::BENCHMARK::Options& options)
+        : families(options.getList("families", "random"))
+        , engines(options.getList("engines", "impQR,batchQR"))
+        , precisions(options.getList("precisions", "float,double"))
+        , warmup((int)options.getInt("warmup", 1))
+        , repeat((int)options.getInt("repeat", 10))
+        , outlier_threshold(options.getDouble("outlier", 3.5))
+        , pin(options.getBool("pin", true))
+        , format(JIXIE::BENCHMARK::Report::format(options.get("format", "text")))
+        , output(options.get("output", ""))
+        , parameters(options)
+        , stream(options.getBool("stream", false))
+        , chunk((size_t)options.getInt("chunk", 4096))
+        , accuracy(options.getBool("accuracy", false))
+        , sweep(options.getBool("sweep", false))
+        , expand((int)options.getInt("expand", 0))
+        , latency((size_t)options.getInt("latency", 0))
+        , budget(options.getDouble("budget", 0))
+        , histogram(options.getBool("histogram", false))
+        , counters(options.getBool("counters", false))
+    {
+        for (const std::string& t : options.getList("threads", "1")) {
+            threads.push_back(t == "max" ? (int)std::max(1u, std::thread::hardware_concurrency()) : (int)JIXIE::BENCHMARK::Options::toInt(t));
+            if (threads.back() < 1)
+                throw std::invalid_argument("threads must be at least 1");
+        }
+        for (const std::string& n : options.getList("sizes", "0"))
+            sizes.push_back((size_t)JIXIE::BENCHMARK::Options::toInt(n));
+        for (const std::string& p : precisions)
+            if (p != "float" && p != "double")
+                throw std::invalid_argument("unknown precision " + p);
+        if (repeat < 1 || warmup < 0)
+            throw std::invalid_argument("repeat must be at least 1 and warmup at least 0");
+        if (chunk < 1)
+            throw std::invalid_argument("chunk must be at least 1");
+        if (accuracy && !stream)
+            throw std::invalid_argument("accuracy needs stream=true");
+        if (expand < 0 || expand > JIXIE::IntegerOrbits<float>::group_size)
+            throw std::invalid_argument("expand must be between 0 and " + std::to_string(JIXIE::IntegerOrbits<float>::group_size));
+        if (expand && !sweep)
+            throw std::invalid_argument("expand needs sweep=true");
+        for (const std::string& engine : engines)
+            if (sweep && engine != "impQR" && engine != "qJacobi" && engine != "structured" && engine != "smallStrain" && engine != "dispatch" && engine != "batchQR")
+                throw std::invalid_argument("the sweep runs the svd engines impQR, qJacobi, structured, smallStrain, dispatch and batchQR, not " + engine);
+        if (latency && sweep)
+            throw std::invalid_argument("latency does not apply to sweep=true");
+        if (counters && sweep)
+            throw std::invalid_argument("counters does not apply to sweep=true");
+        if ((budget > 0 || histogram) && !latency)
+            throw std::invalid_argument("budget and histogram need latency");
+        std::vector<Eigen::Matrix3f> no_tests;
+        HarnessBuffers<float> no_buffers(no_tests);
+        for (const std::string& engine : engines) {
+            // throw for unknown engines
+            if (stream || sweep)
+                chunkEngine<float>(engine);
+            else
+                harnessEngine(engine, no_tests, no_buffers);
+            if (latency && engine != "generate")
+                singleEngine<float>(engine);
+        }
+    }
+};
+
+/**
+   The harness without stored cases: every pass generates its cases chunk by chunk on the threads
+   that decompose them, so memory stays at one chunk per thread whatever the family size.
+   With accuracy=true an untimed pass checks every case first.
+*/
+template <class T>
+void runStreamingHarness(const HarnessConfig& config, std::vector<std::unique_ptr<JIXIE::ThreadPool> >& pools, JIXIE::BENCHMARK::Report& report)
+{
+    using namespace JIXIE;
+    typedef AccuracyErrors<T> Errors;
+    const char* precision = sizeof(T) == sizeof(float) ? "float" : "double";
+    for (const std::string& family : config.families) {
+        std::unique_ptr<CaseGenerator<T> > cases = makeCaseGenerator<T>(family, config.parameters);
+        for (size_t size : config.sizes) {
+            // size 0 keeps the family as it is, anything else repeats or truncates it
+            const size_t n = size ? size : cases->size();
+            for (const std::string& engine : config.engines) {
+                auto run = chunkEngine<T>(engine);
+                LatencyProfile latency;
+                if (config.latency && engine != "generate")
+                    latency = measureLatency<T>(engine, [&](size_t i) { return cases->get(i % cases->size()); }, n, config.latency);
+                if (config.histogram)
+                    printLatencyProfile(std::cerr, std::string(precision) + " " + family + " " + engine, latency);
+                CounterProfile counters;
+                if (config.counters) {
+                    ChunkBuffers<T> b(config.chunk);
+                    counters = countPass(n, [&] {
+                        for (size_t begin = 0; begin < n;) {
+                            size_t first = begin % cases->size();
+                            size_t count = std::min(std::min(n - begin, config.chunk), cases->size() - first);
+                            run(*cases, first, count, b, false);
+                            begin += count;
+                        }
+                    });
+                }
+                for (size_t p = 0; p < pools.size(); p++) {
+                    ThreadPool& pool = *pools[p];
+                    std::vector<std::unique_ptr<ChunkBuffers<T> > > buffers(pool.size());
+                    for (auto& b : buffers)
+                        b.reset(new ChunkBuffers<T>(config.chunk));
+                    auto pass = [&](const bool check) {
+                        pool.parallelFor(n, config.chunk, [&](size_t begin, size_t end, int thread) {
+                            // a chunk that wraps around the end of the family is done in two pieces
+                            while (begin < end) {
+                                size_t first = begin % cases->size();
+                                size_t count = std::min(end - begin, cases->size() - first);
+                                run(*cases, first, count, *buffers[thread], check);
+                                begin += count;
+                            }
+                        });
+                    };
+                    Errors errors;
+                    if (config.accuracy) {
+                        pass(true);
+                        for (auto& b : buffers)
+                            errors += b->errors;
+                    }
+                    std::cerr << precision << " " << family << " " << n << " " << engine << " threads " << config.threads[p] << " streamed" << std::endl;
+                    std::vector<double> seconds = BENCHMARK::measure(config.warmup, config.repeat, [&] { pass(false); });
+                    BENCHMARK::Summary s = BENCHMARK::summarize(seconds, config.outlier_threshold);
+                    double per_matrix = 1e9 / n;
+                    BENCHMARK::Report::Row& row = report.add()
+                                                      .set("precision", precision)
+                                                      .set("family", family)
+                                                      .set("cases", n)
+                                                      .set("engine", engine)
+                                                      .set("threads", config.threads[p])
+                                                      .set("repeats", s.samples)
+                                                      .set("kept", s.kept)
+                                                      .set("ns_per_matrix", s.mean * per_matrix)
+                                                      .set("ci95_ns", s.ci95 * per_matrix)
+                                                      .set("median_ns", s.median * per_matrix)
+                                                      .set("min_ns", s.min * per_matrix)
+                                                      .set("max_ns", s.max * per_matrix)
+                                                      .set("stddev_ns", s.stddev * per_matrix)
+                                                      .set("matrices_per_s", n / s.mean);
+                    if (config.latency)
+                        setLatencyColumns(row, latency, config.budget);
+                    if (config.counters)
+                        setCounterColumns(row, counters);
+                    for (int m = 0; config.accuracy && m < Errors::MetricCount; m++) {
+                        typename Errors::Metric metric = (typename Errors::Metric)m;
+                        row.set(std::string(Errors::name(metric)) + "_max", errors.max(metric))
+                            .set(std::string(Errors::name(metric)) + "_ave", errors.average(metric))
+                            .set(std::string(Errors::name(metric)) + "_ulp_max", errors.maxUlps(metric))
+                            .set(std::string(Errors::name(metric)) + "_worst", errors.count(metric) ? (double)errors.metric(metric).worst_index : std::numeric_limits<double>::quiet_NaN());
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+   Images of the representatives of IntegerOrbits: case i * expand + e is representative i
+   transformed by group element e * group_size / expand, so the images spread over the group.
+*/
+template <class T>
+class OrbitImages : public JIXIE::CaseGenerator<T> {
+public:
+    typedef typename JIXIE::CaseGenerator<T>::Matrix Matrix;
+
+    OrbitImages(const JIXIE::IntegerOrbits<T>& orbits, const int expand)
+        : orbits(orbits)
+        , expand(expand)
+    {
+    }
+
+    size_t size() const override
+    {
+        return orbits.size() * expand;
+    }
+
+    Matrix get(const size_t i) const override
+    {
+        return orbits.image(orbits.get(i / expand), (int)(i % expand) * JIXIE::IntegerOrbits<T>::group_size / expand);
+    }
+
+private:
+    const JIXIE::IntegerOrbits<T>& orbits;
+    const int expand;
+};
+
+/**
+   Exhaustive sweep of the integer cases that decomposes and checks one representative per
+   symmetry orbit, see IntegerOrbits. With expand > 0 every engine also decomposes that many images
+   of each representative, whose singular values must equal those of the representative up to sign;
+   the largest difference is reported in ulps of the Frobenius norm.
+*/
+template <class T>
+void runIntegerSweep(const HarnessConfig& config, std::vector<std::unique_ptr<JIXIE::ThreadPool> >& pools, JIXIE::BENCHMARK::Report& report)
+{
+    using namespace JIXIE;
+    typedef AccuracyErrors<T> Errors;
+    const char* precision = sizeof(T) == sizeof(float) ? "float" : "double";
+    std::cerr << precision << " enumerating the symmetry orbits of the integer cases of range " << config.parameters.integer_range << std::endl;
+    Timer timer;
+    timer.start();
+    IntegerOrbits<T> orbits(config.parameters.integer_range);
+    const double enumerate_seconds = timer.click();
+    OrbitImages<T> images(orbits, std::max(config.expand, 1));
+    const size_t n = orbits.size();
+    const size_t image_count = config.expand ? images.size() : 0;
+    std::vector<Eigen::Matrix<T, 3, 1> > reference(n);
+    for (const std::string& engine : config.engines) {
+        auto run = chunkEngine<T>(engine);
+        const bool streamed = engine == "batchQR";
+        for (size_t p = 0; p < pools.size(); p++) {
+            ThreadPool& pool = *pools[p];
+            std::vector<std::unique_ptr<ChunkBuffers<T> > > buffers(pool.size());
+            for (auto& b : buffers)
+                b.reset(new ChunkBuffers<T>(config.chunk));
+            auto singularValues = [&](const ChunkBuffers<T>& b, const size_t j) {
+                return streamed ? b.sigma_streams.get(j) : b.sigma[j];
+            };
+            std::cerr << precision << " sweep of " << n << " orbits " << engine << " threads " << config.threads[p] << std::endl;
+            timer.start();
+            pool.parallelFor(n, config.chunk, [&](size_t begin, size_t end, int thread) {
+                ChunkBuffers<T>& b = *buffers[thread];
+                run(orbits, begin, end - begin, b, true);
+                for (size_t i = begin; i < end; i++)
+                    reference[i] = singularValues(b, i - begin);
+            });
+            const double sweep_seconds = timer.click();
+            Errors errors;
+            for (auto& b : buffers)
+                errors += b->errors;
+
+            // the images are checked against the singular values of their representative
+            std::vector<T> thread_ulps(pool.size(), 0);
+            std::vector<size_t> thread_worst(pool.size(), 0);
+            pool.parallelFor(image_count, config.chunk, [&](size_t begin, size_t end, int thread) {
+                ChunkBuffers<T>& b = *buffers[thread];
+                run(images, begin, end - begin, b, false);
+                for (size_t i = begin; i < end; i++) {
+                    const Eigen::Matrix<T, 3, 1>& expected = reference[i / config.expand];
+                    T difference = (singularValues(b, i - begin).cwiseAbs() - expected.cwiseAbs()).cwiseAbs().maxCoeff();
+                    T ulps = Errors::ulpsOf(difference, expected.norm());
+                    if (ulps > thread_ulps[thread] || std::isnan(ulps)) {
+                        thread_ulps[thread] = ulps;
+                        thread_worst[thread] = i;
+                    }
+                }
+            });
+            const double expand_seconds = timer.click();
+            size_t worst = std::max_element(thread_ulps.begin(), thread_ulps.end()) - thread_ulps.begin();
+
+            BENCHMARK::Report::Row& row = report.add()
+                                              .set("precision", precision)
+                                              .set("family", "integer_orbits")
+                                              .set("integer_range", config.parameters.integer_range)
+                                              .set("grid_cases", orbits.gridSize())
+                                              .set("orbits", n)
+                                              .set("reduction", (double)orbits.gridSize() / n)
+                                              .set("enumerate_s", enumerate_seconds)
+                                              .set("engine", engine)
+                                              .set("threads", config.threads[p])
+                                              .set("sweep_s", sweep_seconds)
+                                              .set("ns_per_orbit", sweep_seconds * 1e9 / n)
+                                              .set("images", image_count)
+                                              .set("expand_s", expand_seconds)
+                                              .set("sigma_ulp_max", thread_ulps[worst])
+                                              .set("sigma_worst", image_count ? (double)orbits.gridIndex(thread_worst[worst] / config.expand) : std::numeric_limits<double>::quiet_NaN())
+                                              .set("sigma_worst_element", image_count ? (double)(thread_worst[worst] % config.expand * IntegerOrbits<T>::group_size / config.expand) : std::numeric_limits<double>::quiet_NaN());
+            for (int m = 0; m < Errors::Symmetry; m++) {
+                typename Errors::Metric metric = (typename Errors::Metric)m;
+                row.set(std::string(Errors::name(metric)) + "_max", errors.max(metric))
+                    .set(std::string(Errors::name(metric)) + "_ulp_max", errors.maxUlps(metric))
+                    .set(std::string(Errors::name(metric)) + "_worst", (double)orbits.gridIndex(errors.metric(metric).worst_index));
+            }
+        }
+    }
+}
+
+template <class T>
+void runHarness(const HarnessConfig& config, std::vector<std::unique_ptr<JIXIE::ThreadPool> >& pools, JIXIE::BENCHMARK::Report& report)
+{
+    using namespace JIXIE;
+    if (config.sweep) {
+        runIntegerSweep<T>(config, pools, report);
+        return;
+    }
+    if (config.stream) {
+        runStreamingHarness<T>(config, pools, report);
+        return;
+    }
+    const char* precision = sizeof(T) == sizeof(float) ? "float" : "double";
+    for (const std::string& family : config.families) {
+        std::vector<Eigen::Matrix<T, 3, 3> > family_tests;
+        addCases(family_tests, family, config.parameters);
+        for (size_t size : config.sizes) {
+            // size 0 keeps the family as it is, anything else repeats or truncates it
+            std::vector<Eigen::Matrix<T, 3, 3> > tests(size ? size : family_tests.size());
+            for (size_t i = 0; i < tests.size(); i++)
+                tests[i] = family_tests[i % family_tests.size()];
+            HarnessBuffers<T> buffers(tests);
+            for (const std::string& engine : config.engines) {
+                std::function<void(ThreadPool&)> run = harnessEngine(engine, tests, buffers);
+                LatencyProfile latency;
+                if (config.latency)
+                    latency = measureLatency<T>(engine, [&](size_t i) { return tests[i]; }, tests.size(), config.latency);
+                if (config.histogram)
+                    printLatencyProfile(std::cerr, std::string(precision) + " " + family + " " + engine, latency);
+                CounterProfile counters;
+                if (config.counters) {
+                    ThreadPool single(1, false);
+                    counters = countPass(tests.size(), [&] { run(single); });
+                }
+                for (size_t p = 0; p < pools.size(); p++) {
+                    std::cerr << precision << " " << family << " " << tests.size() << " " << engine << " threads " << config.threads[p] << std::endl;
+                    std::vector<double> seconds = BENCHMARK::measure(config.warmup, config.repeat, [&] { run(*pools[p]); });
+                    BENCHMARK::Summary s = BENCHMARK::summarize(seconds, config.outlier_threshold);
+                    double per_matrix = 1e9 / tests.size();
+                    BENCHMARK::Report::Row& row = report.add()
+                                                      .set("precision", precision)
+                                                      .set("family", family)
+                                                      .set("cases", tests.size())
+                                                      .set("engine", engine)
+                                                      .set("threads", config.threads[p])
+                                                      .set("repeats", s.samples)
+                                                      .set("kept", s.kept)
+                                                      .set("ns_per_matrix", s.mean * per_matrix)
+                                                      .set("ci95_ns", s.ci95 * per_matrix)
+                                                      .set("median_ns", s.median * per_matrix)
+                                                      .set("min_ns", s.min * per_matrix)
+                                                      .set("max_ns", s.max * per_matrix)
+                                                      .set("stddev_ns", s.stddev * per_matrix)
+                                                      .set("matrices_per_s", tests.size() / s.mean);
+                    if (config.latency)
+                        setLatencyColumns(row, latency, config.budget);
+                    if (config.counters)
+                        setCounterColumns(row, counters);
+                }
+            }
+        }
+    }
+}
+
+/**
+   Redirects std::cout to std::cerr, so that stdout only carries the report
+*/
+class CoutToCerr {
+public:
+    CoutToCerr()
+        : old(std::cout.rdbuf(std::cerr.rdbuf()))
+    {
+    }
+    ~CoutToCerr()
+    {
+        std::cout.rdbuf(old);
+    }
+
+private:
+    std::streambuf* old;
+};
+
+void printHarnessUsage(std::ostream& out)
+{
+    out << "usage: ./a [key=value ...] [config=file]\n"
+        << "  families=random,integer,integer_orbits,integer_perturbation[:256eps],identity_perturbation[:1e-3]\n"
+        << "           clustered,ill_conditioned,near_rank1,near_inversion,scaled (U diag(sigma) V' with adversarial sigma)\n"
+        << "           diagonal,symmetric,bidiagonal,rotation,mixed_structure (inputs of the structured engine fast paths)\n"
+        << "  engines=impQR,qJacobi,structured,smallStrain,batchQR,polar,polarPacked,smallStrainPolar,dispatch (and generate with stream=true)\n"
+        << "  precisions=float,double\n"
+        << "  threads=1,2,max   sizes=0 (0 keeps the family size)   warmup=1   repeat=10\n"
+        << "  outlier=3.5 (modified z-score, 0 keeps all)   pin=true   format=text|csv|json   output=file\n"
+        << "  random_range=3 random_count=1048576 integer_range=2 perturbation_count=4 identity_count=1048576\n"
+        << "  structure_count=1048576\n"
+        << "  stream=false (true generates the cases inside the passes, in constant memory)   chunk=4096\n"
+        << "  accuracy=false (with stream=true, an untimed pass first checks every case)\n"
+        << "  sweep=false (true checks one integer case per symmetry orbit instead of the families)\n"
+        << "  expand=0 (with sweep=true, images of each orbit representative whose singular values are compared, up to 2304)\n"
+        << "  latency=0 (cases timed one at a time with rdtsc for iteration and latency percentile columns)   spectrum_count=1048576\n"
+        << "  budget=0 (with latency, ns per matrix: adds the share over budget)   histogram=false (with latency, prints latency histograms)\n"
+        << "  counters=false (true adds IPC, misses per matrix and GFLOP/s of a single threaded pass, from perf_event_open)" << std::endl;
+}
+
+/**
+   Configurable benchmark that writes ns/matrix, matrices/s and 95% confidence intervals as text, CSV or JSON
+*/
+int runBenchmarkHarness(const int argc, const char* const argv[])
+{
+    using namespace JIXIE;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "help" || a == "-h" || a == "--help") {
+            printHarnessUsage(std::cout);
+            return 0;
+        }
+    }
+    BENCHMARK::Options options;
+    std::unique_ptr<HarnessConfig> config;
+    try {
+        options = BENCHMARK::Options(argc, argv);
+        config.reset(new HarnessConfig(options));
+        for (const std::string& key : options.unused())
+            throw std::invalid_argument("unknown option " + key);
+    }
+    catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        printHarnessUsage(std::cerr);
+        return 1;
+    }
+
+    // Workers are pinned over all the allowed cpus, the calling thread to the first one
+    BENCHMARK::CpuPinning pinning;
+    std::vector<std::unique_ptr<ThreadPool> > pools;
+    for (int threads : config->threads) {
+        pinning.restore();
+        pools.emplace_back(new ThreadPool(threads, config->pin));
+    }
+    int cpu = config->pin ? pinning.pin() : -1;
+
+    BENCHMARK::Report report;
+    report.header()
+        .set("isa", DISPATCH::bestKernels().name)
+        .set("hardware_threads", std::thread::hardware_concurrency())
+        .set("pinned_cpu", cpu)
+        .set("warmup", config->warmup)
+        .set("repeat", config->repeat)
+        .set("outlier_threshold", config->outlier_threshold);
+    if (config->latency)
+        report.header()
+            .set("tsc_ghz", CycleTimer::ticksPerNanosecond())
+            .set("tsc_invariant", CycleTimer::invariant())
+            .set("tsc_overhead_ticks", CycleTimer::overhead());
+    try {
+        CoutToCerr redirect;
+        for (const std::string& precision : config->precisions) {
+            if (precision == "float")
+                runHarness<float>(*config, pools, report);
+            else
+                runHarness<double>(*config, pools, report);
+        }
+    }
+    catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    if (config->output.empty()) {
+        report.write(std::cout, config->format);
+        return 0;
+    }
+    std::ofstream out(config->output);
+    report.write(out, config->format);
+    if (!out) {
+        std::cerr << "cannot write " << config->output << std::endl;
+        return 1;
+    }
+    return 0;
 }
 
 float det(const Eigen::Matrix2f& A) {
@@ -606,10 +1688,29 @@ void My_Polar(const Eigen::Matrix3f& F,Eigen::Matrix3f& R,Eigen::Matrix3f& S){
 void my_benchmark_SVD();
 void my_benchmark_Polar();
 
-int main()
+int main(int argc, char* argv[])
 {
+  if (argc > 1)
+    return runBenchmarkHarness(argc, argv);
+
   bool run_benchmark = false;
   if (run_benchmark) runBenchmark();
+
+  bool run_warm_start_benchmark = false;
+  if (run_warm_start_benchmark) {
+    runWarmStartBenchmark<float>(1024 * 64, 16, 0.01f);
+    runWarmStartBenchmark<double>(1024 * 64, 16, 0.01);
+    runWarmStartBenchmark<double>(1024 * 64, 16, 0.001);
+    runWarmStartBenchmark<double>(1024 * 64, 16, 0.1);
+  }
+
+  bool run_warm_polar_benchmark = false;
+  if (run_warm_polar_benchmark) {
+    runWarmPolarBenchmark<float>(1024 * 64, 16, 0.01f);
+    runWarmPolarBenchmark<double>(1024 * 64, 16, 0.01);
+    runWarmPolarBenchmark<double>(1024 * 64, 16, 0.001);
+    runWarmPolarBenchmark<double>(1024 * 64, 16, 0.1);
+  }
   
   bool run_my_benchmark_SVD = false;
   bool run_my_benchmark_Polar = false;
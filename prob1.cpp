@@ -32,6 +32,7 @@
 #include <iostream>
 #include "Tools.h"
 #include "ImplicitQRSVD.h"
+#include "DispatchSVD.h"
 #include "2dSVD.h"
 
 // Some shortening of names of stuff here
@@ -51,5 +52,13 @@ int main() {
 
     svd(F,U,Sigma,V,verbose_flag);
 
+    // The same F through the runtime dispatched 3x3 kernels, as the upper block of diag(F, 1)
+    Eigen::Matrix<T, 3, 3> F3 = Eigen::Matrix<T, 3, 3>::Identity(), U3, V3;
+    F3.topLeftCorner<2, 2>() = F;
+    Eigen::Matrix<T, 3, 1> sigma3;
+    JIXIE::DISPATCH::singularValueDecomposition(1, &F3, &U3, &sigma3, &V3);
+    std::cout << "\nThe " << JIXIE::DISPATCH::bestKernels().name << " kernels give singular values of diag(F, 1)" << std::endl;
+    std::cout << sigma3.transpose() << std::endl;
+
     return 0;
 }
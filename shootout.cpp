@@ -0,0 +1,395 @@
+/**
+   Copyright (c) 2016 Theodore Gast, Chuyuan Fu, Chenfanfu Jiang, Joseph Teran
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   If the code is used in an article, the following paper shall be cited:
+   @techreport{qrsvd:2016,
+   title={Implicit-shifted Symmetric QR Singular Value Decomposition of 3x3 Matrices},
+   author={Gast, Theodore and Fu, Chuyuan and Jiang, Chenfanfu and Teran, Joseph},
+   year={2016},
+   institution={University of California Los Angeles}
+   }
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+
+   ################################################################################
+   Engine shoot-out: the same case families through the JIXIE engines, Eigen's
+   JacobiSVD, an eigen decomposition of A'A with SelfAdjointEigenSolver::computeDirect,
+   the algorithms of 2dSVD.h and 3dPolar.h, the Newton iterations of NewtonPolar.h and the small strain
+   closed form of SmallStrainPolar.h. Every row gives the throughput and the accuracy errors of one engine
+   on one family.
+
+   make shootout
+   ./shootout families=random,integer problems=svd3,polar3 precisions=double format=csv
+   ################################################################################
+*/
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include "Tools.h"
+#include "ImplicitQRSVD.h"
+#include "QuaternionJacobiSVD.h"
+#include "BatchSVD.h"
+#include "NewtonPolar.h"
+#include "SmallStrainPolar.h"
+#include "Benchmark.h"
+#include "TestCases.h"
+#include "2dSVD.h"
+#include "3dPolar.h"
+
+/**
+   Eigen's JacobiSVD with the sign conventions of JIXIE: U and V are rotations and only the last singular value may be negative
+*/
+template <class T, int dim>
+void eigenJacobiSVD(const Eigen::Matrix<T, dim, dim>& A, Eigen::Matrix<T, dim, dim>& U, Eigen::Matrix<T, dim, 1>& sigma, Eigen::Matrix<T, dim, dim>& V)
+{
+    Eigen::JacobiSVD<Eigen::Matrix<T, dim, dim> > svd(A, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    U = svd.matrixU();
+    V = svd.matrixV();
+    sigma = svd.singularValues();
+    if (U.determinant() < 0) {
+        U.col(dim - 1) = -U.col(dim - 1);
+        sigma(dim - 1) = -sigma(dim - 1);
+    }
+    if (V.determinant() < 0) {
+        V.col(dim - 1) = -V.col(dim - 1);
+        sigma(dim - 1) = -sigma(dim - 1);
+    }
+}
+
+/**
+   SVD from the closed form eigen decomposition of A'A. U is Gram-Schmidt on the columns of AV.
+*/
+template <class T>
+void selfAdjointSVD(const Eigen::Matrix<T, 3, 3>& A, Eigen::Matrix<T, 3, 3>& U, Eigen::Matrix<T, 3, 1>& sigma, Eigen::Matrix<T, 3, 3>& V)
+{
+    typedef Eigen::Matrix<T, 3, 3> Matrix3;
+    Eigen::SelfAdjointEigenSolver<Matrix3> solver;
+    Matrix3 C = A.transpose() * A;
+    solver.computeDirect(C);
+    // eigenvalues are increasing, singular values decreasing
+    V = solver.eigenvectors().rowwise().reverse();
+    if (V.determinant() < 0)
+        V.col(2) = -V.col(2);
+    Matrix3 B = A * V;
+    T norm = B.col(0).norm();
+    U.col(0) = norm > 0 ? (Eigen::Matrix<T, 3, 1>)(B.col(0) / norm) : Eigen::Matrix<T, 3, 1>::UnitX();
+    Eigen::Matrix<T, 3, 1> u1 = B.col(1) - U.col(0) * U.col(0).dot(B.col(1));
+    norm = u1.norm();
+    U.col(1) = norm > std::numeric_limits<T>::epsilon() * sigma.size() * B.col(0).norm() ? (Eigen::Matrix<T, 3, 1>)(u1 / norm) : U.col(0).unitOrthogonal();
+    U.col(2) = U.col(0).cross(U.col(1));
+    for (int i = 0; i < 3; i++)
+        sigma(i) = U.col(i).dot(B.col(i));
+}
+
+/**
+   Polar decomposition from Eigen's JacobiSVD
+*/
+template <class T>
+void eigenJacobiPolar(const Eigen::Matrix<T, 3, 3>& F, Eigen::Matrix<T, 3, 3>& R, Eigen::Matrix<T, 3, 3>& S)
+{
+    Eigen::Matrix<T, 3, 3> U, V;
+    Eigen::Matrix<T, 3, 1> sigma;
+    eigenJacobiSVD(F, U, sigma, V);
+    R.noalias() = U * V.transpose();
+    S.noalias() = V * sigma.asDiagonal() * V.transpose();
+}
+
+/**
+   Options of the shoot-out
+*/
+struct ShootoutConfig {
+    std::vector<std::string> families;
+    std::vector<std::string> problems;
+    std::vector<std::string> engines; // empty means all
+    std::vector<std::string> precisions;
+    size_t cases;
+    int warmup;
+    int repeat;
+    double outlier_threshold;
+    JIXIE::BENCHMARK::Report::Format format;
+    std::string output;
+    JIXIE::CaseParameters parameters;
+
+    ShootoutConfig(const JIXIE::BENCHMARK::Options& options)
+        : families(options.getList("families", "random,integer,integer_perturbation,identity_perturbation"))
+        , problems(options.getList("problems", "svd3,svd2,polar3"))
+        , engines(options.getList("engines", ""))
+        , precisions(options.getList("precisions", "float,double"))
+        , cases((size_t)options.getInt("cases", 65536))
+        , warmup((int)options.getInt("warmup", 1))
+        , repeat((int)options.getInt("repeat", 5))
+        , outlier_threshold(options.getDouble("outlier", 3.5))
+        , format(JIXIE::BENCHMARK::Report::format(options.get("format", "text")))
+        , output(options.get("output", ""))
+        , parameters(options)
+    {
+        for (const std::string& p : problems)
+            if (p != "svd3" && p != "svd2" && p != "polar3")
+                throw std::invalid_argument("unknown problem " + p);
+        for (const std::string& p : precisions)
+            if (p != "float" && p != "double")
+                throw std::invalid_argument("unknown precision " + p);
+        if (repeat < 1 || warmup < 0)
+            throw std::invalid_argument("repeat must be at least 1 and warmup at least 0");
+    }
+
+    bool selected(const std::string& engine) const
+    {
+        return engines.empty() || std::find(engines.begin(), engines.end(), engine) != engines.end();
+    }
+};
+
+/**
+   Times one engine and adds its row. pass() runs the engine over every case, errors() checks the output of the last pass.
+*/
+template <class T, class Pass, class Errors>
+void shoot(const ShootoutConfig& config, JIXIE::BENCHMARK::Report& report, double& baseline,
+    const std::string& family, const std::string& problem, const std::string& engine, const size_t n, Pass pass, Errors errors)
+{
+    using namespace JIXIE;
+    if (!config.selected(engine))
+        return;
+    const char* precision = sizeof(T) == sizeof(float) ? "float" : "double";
+    std::cerr << precision << " " << family << " " << problem << " " << engine << std::endl;
+    BENCHMARK::Summary s = BENCHMARK::summarize(BENCHMARK::measure(config.warmup, config.repeat, pass), config.outlier_threshold);
+    AccuracyErrors<T> e = errors();
+    if (baseline == 0)
+        baseline = s.mean;
+    double per_matrix = 1e9 / n;
+    BENCHMARK::Report::Row& row = report.add()
+                                      .set("precision", precision)
+                                      .set("family", family)
+                                      .set("problem", problem)
+                                      .set("engine", engine)
+                                      .set("cases", n)
+                                      .set("ns_per_matrix", s.mean * per_matrix)
+                                      .set("ci95_ns", s.ci95 * per_matrix)
+                                      .set("matrices_per_s", n / s.mean)
+                                      .set("speedup", baseline / s.mean);
+    for (int m = 0; m < AccuracyErrors<T>::MetricCount; m++) {
+        typename AccuracyErrors<T>::Metric metric = (typename AccuracyErrors<T>::Metric)m;
+        row.set(std::string(AccuracyErrors<T>::name(metric)) + "_max", e.max(metric));
+        row.set(std::string(AccuracyErrors<T>::name(metric)) + "_ave", e.average(metric));
+        row.set(std::string(AccuracyErrors<T>::name(metric)) + "_std", e.standardDeviation(metric));
+        row.set(std::string(AccuracyErrors<T>::name(metric)) + "_ulp_max", e.maxUlps(metric));
+        row.set(std::string(AccuracyErrors<T>::name(metric)) + "_ulp_ave", e.averageUlps(metric));
+    }
+}
+
+template <class T, class Engine>
+void shootSVD3(const ShootoutConfig& config, JIXIE::BENCHMARK::Report& report, double& baseline,
+    const std::string& family, const std::string& engine, const std::vector<Eigen::Matrix<T, 3, 3> >& tests, Engine svd)
+{
+    size_t n = tests.size();
+    std::vector<Eigen::Matrix<T, 3, 3> > U(n), V(n);
+    std::vector<Eigen::Matrix<T, 3, 1> > sigma(n);
+    shoot<T>(config, report, baseline, family, "svd3", engine, n, [&] {
+            for (size_t i = 0; i < n; i++)
+                svd(tests[i], U[i], sigma[i], V[i]); }, [&] {
+            JIXIE::AccuracyErrors<T> e;
+            for (size_t i = 0; i < n; i++)
+                e.addSVD(tests[i], U[i], sigma[i], V[i], i);
+            return e; });
+}
+
+template <class T, class Engine>
+void shootSVD2(const ShootoutConfig& config, JIXIE::BENCHMARK::Report& report, double& baseline,
+    const std::string& family, const std::string& engine, const std::vector<Eigen::Matrix<T, 2, 2> >& tests, Engine svd)
+{
+    size_t n = tests.size();
+    std::vector<Eigen::Matrix<T, 2, 2> > U(n), V(n);
+    std::vector<Eigen::Matrix<T, 2, 1> > sigma(n);
+    shoot<T>(config, report, baseline, family, "svd2", engine, n, [&] {
+            for (size_t i = 0; i < n; i++)
+                svd(tests[i], U[i], sigma[i], V[i]); }, [&] {
+            JIXIE::AccuracyErrors<T> e;
+            for (size_t i = 0; i < n; i++)
+                e.addSVD(tests[i], U[i], sigma[i], V[i], i);
+            return e; });
+}
+
+/**
+   Symmetric is the type the engine writes S to, a dense matrix or a JIXIE::SymmetricMatrix3
+*/
+template <class T, class Symmetric = Eigen::Matrix<T, 3, 3>, class Engine>
+void shootPolar3(const ShootoutConfig& config, JIXIE::BENCHMARK::Report& report, double& baseline,
+    const std::string& family, const std::string& engine, const std::vector<Eigen::Matrix<T, 3, 3> >& tests, Engine polar)
+{
+    size_t n = tests.size();
+    std::vector<Eigen::Matrix<T, 3, 3> > R(n);
+    std::vector<Symmetric> S(n);
+    shoot<T>(config, report, baseline, family, "polar3", engine, n, [&] {
+            for (size_t i = 0; i < n; i++)
+                polar(tests[i], R[i], S[i]); }, [&] {
+            JIXIE::AccuracyErrors<T> e;
+            for (size_t i = 0; i < n; i++)
+                e.addPolar(tests[i], R[i], S[i], i);
+            return e; });
+}
+
+/**
+   Batched polar decomposition on structure-of-arrays copies of the tests, S in 6 streams
+*/
+template <class T, class Engine>
+void shootBatchPolar3(const ShootoutConfig& config, JIXIE::BENCHMARK::Report& report, double& baseline,
+    const std::string& family, const std::string& engine, const std::vector<Eigen::Matrix<T, 3, 3> >& tests, Engine polar)
+{
+    if (!config.selected(engine))
+        return;
+    size_t n = tests.size();
+    JIXIE::MatrixStreams<T, 3, 3> A(n), R(n);
+    JIXIE::MatrixStreams<T, 6, 1> S(n);
+    for (size_t i = 0; i < n; i++)
+        A.set(i, tests[i]);
+    shoot<T>(config, report, baseline, family, "polar3", engine, n, [&] { polar(n, A.streams(), R.streams(), S.streams()); }, [&] {
+            JIXIE::AccuracyErrors<T> e;
+            for (size_t i = 0; i < n; i++) {
+                JIXIE::SymmetricMatrix3<T> S_i;
+                for (int k = 0; k < 6; k++)
+                    S_i.data[k] = S.streams()[k][i];
+                e.addPolar(tests[i], R.get(i), S_i, i);
+            }
+            return e; });
+}
+
+/**
+   The 2x2 algorithm of 2dSVD.h only exists in double
+*/
+inline void classSVD2(const Eigen::Matrix<float, 2, 2>&, Eigen::Matrix<float, 2, 2>&, Eigen::Matrix<float, 2, 1>&, Eigen::Matrix<float, 2, 2>&) {}
+inline void classSVD2(const Eigen::Matrix2d& A, Eigen::Matrix2d& U, Eigen::Vector2d& sigma, Eigen::Matrix2d& V)
+{
+    svd(A, U, sigma, V, false);
+}
+
+template <class T>
+void runShootout(const ShootoutConfig& config, JIXIE::BENCHMARK::Report& report)
+{
+    using namespace JIXIE;
+    typedef Eigen::Matrix<T, 3, 3> Matrix3;
+    typedef Eigen::Matrix<T, 3, 1> Vector3;
+    typedef Eigen::Matrix<T, 2, 2> Matrix2;
+    typedef Eigen::Matrix<T, 2, 1> Vector2;
+    for (const std::string& family : config.families) {
+        std::vector<Matrix3> family_tests;
+        addCases(family_tests, family, config.parameters);
+        // an evenly strided sample, so that every part of an enumerated family is represented
+        size_t n = std::min(config.cases ? config.cases : family_tests.size(), family_tests.size());
+        std::vector<Matrix3> tests(n);
+        for (size_t i = 0; i < n; i++)
+            tests[i] = family_tests[i * family_tests.size() / n];
+
+        for (const std::string& problem : config.problems) {
+            double baseline = 0;
+            if (problem == "svd3") {
+                shootSVD3(config, report, baseline, family, "impQR", tests, [](const Matrix3& A, Matrix3& U, Vector3& s, Matrix3& V) { singularValueDecomposition(A, U, s, V); });
+                shootSVD3(config, report, baseline, family, "qJacobi", tests, [](const Matrix3& A, Matrix3& U, Vector3& s, Matrix3& V) { singularValueDecomposition<QuaternionJacobi>(A, U, s, V); });
+                shootSVD3(config, report, baseline, family, "structured", tests, [](const Matrix3& A, Matrix3& U, Vector3& s, Matrix3& V) { singularValueDecomposition<Structured>(A, U, s, V); });
+                shootSVD3(config, report, baseline, family, "smallStrain", tests, [](const Matrix3& A, Matrix3& U, Vector3& s, Matrix3& V) { singularValueDecomposition<SmallStrain>(A, U, s, V); });
+                if (config.selected("batchQR")) {
+                    MatrixStreams<T, 3, 3> A_streams(n), U_streams(n), V_streams(n);
+                    MatrixStreams<T, 3, 1> sigma_streams(n);
+                    for (size_t i = 0; i < n; i++)
+                        A_streams.set(i, tests[i]);
+                    shoot<T>(config, report, baseline, family, "svd3", "batchQR", n, [&] { batchSingularValueDecomposition(n, A_streams.streams(), U_streams.streams(), sigma_streams.streams(), V_streams.streams()); }, [&] {
+                            AccuracyErrors<T> e;
+                            checkSVD(e, n, A_streams.streams(), U_streams.streams(), sigma_streams.streams(), V_streams.streams());
+                            return e; });
+                }
+                shootSVD3(config, report, baseline, family, "eigenJacobiSVD", tests, eigenJacobiSVD<T, 3>);
+                shootSVD3(config, report, baseline, family, "eigenSelfAdjoint", tests, selfAdjointSVD<T>);
+            }
+            if (problem == "svd2") {
+                // the leading 2x2 blocks of the family
+                std::vector<Matrix2> tests2(n);
+                for (size_t i = 0; i < n; i++)
+                    tests2[i] = tests[i].template topLeftCorner<2, 2>();
+                shootSVD2(config, report, baseline, family, "impQR", tests2, [](const Matrix2& A, Matrix2& U, Vector2& s, Matrix2& V) { singularValueDecomposition(A, U, s, V); });
+                shootSVD2(config, report, baseline, family, "eigenJacobiSVD", tests2, eigenJacobiSVD<T, 2>);
+                if (sizeof(T) == sizeof(double))
+                    shootSVD2(config, report, baseline, family, "class2dSVD", tests2, [](const Matrix2& A, Matrix2& U, Vector2& s, Matrix2& V) { classSVD2(A, U, s, V); });
+            }
+            if (problem == "polar3") {
+                shootPolar3(config, report, baseline, family, "impQR", tests, [](const Matrix3& F, Matrix3& R, Matrix3& S) { JIXIE::polarDecomposition(F, R, S); });
+                shootPolar3<T, JIXIE::SymmetricMatrix3<T> >(config, report, baseline, family, "impQRPacked", tests, [](const Matrix3& F, Matrix3& R, JIXIE::SymmetricMatrix3<T>& S) { JIXIE::polarDecomposition(F, R, S); });
+                shootPolar3(config, report, baseline, family, "eigenJacobiSVD", tests, eigenJacobiPolar<T>);
+                shootPolar3(config, report, baseline, family, "classGivens", tests, [](const Matrix3& F, Matrix3& R, Matrix3& S) { ::polarDecomposition(F, R, S, false); });
+                shootPolar3(config, report, baseline, family, "scaledNewton", tests, [](const Matrix3& F, Matrix3& R, Matrix3& S) { iterativePolarDecomposition<ScaledNewton>(F, R, S); });
+                shootPolar3(config, report, baseline, family, "newtonSchulz", tests, [](const Matrix3& F, Matrix3& R, Matrix3& S) { iterativePolarDecomposition<NewtonSchulz>(F, R, S); });
+                shootPolar3(config, report, baseline, family, "smallStrain", tests, [](const Matrix3& F, Matrix3& R, Matrix3& S) { smallStrainPolarDecomposition(F, R, S); });
+                shootBatchPolar3(config, report, baseline, family, "batchScaledNewton", tests, [](size_t n, const T* const* F, T* const* R, T* const* S) { batchIterativePolarDecomposition<ScaledNewton>(n, F, R, S); });
+                shootBatchPolar3(config, report, baseline, family, "batchNewtonSchulz", tests, [](size_t n, const T* const* F, T* const* R, T* const* S) { batchIterativePolarDecomposition<NewtonSchulz>(n, F, R, S); });
+                shootBatchPolar3(config, report, baseline, family, "batchSmallStrain", tests, [](size_t n, const T* const* F, T* const* R, T* const* S) { batchSmallStrainPolarDecomposition(n, F, R, S); });
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace JIXIE;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "help" || a == "-h" || a == "--help") {
+            std::cout << "usage: ./shootout [key=value ...] [config=file]\n"
+                      << "  families=random,integer,integer_perturbation[:256eps],identity_perturbation[:1e-3]\n"
+                      << "  problems=svd3,svd2,polar3   engines=all or a list   precisions=float,double\n"
+                      << "  cases=65536 (strided sample of each family, 0 for all)   warmup=1   repeat=5   outlier=3.5\n"
+                      << "  format=text|csv|json   output=file   plus the case family parameters of ./a" << std::endl;
+            return 0;
+        }
+    }
+    std::unique_ptr<ShootoutConfig> config;
+    try {
+        BENCHMARK::Options options(argc, argv);
+        config.reset(new ShootoutConfig(options));
+        for (const std::string& key : options.unused())
+            throw std::invalid_argument("unknown option " + key);
+    }
+    catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    BENCHMARK::Report report;
+    report.header().set("warmup", config->warmup).set("repeat", config->repeat).set("cases", config->cases);
+    std::streambuf* cout_buffer = std::cout.rdbuf(std::cerr.rdbuf()); // case generation chatter goes to stderr
+    try {
+        for (const std::string& precision : config->precisions) {
+            if (precision == "float")
+                runShootout<float>(*config, report);
+            else
+                runShootout<double>(*config, report);
+        }
+    }
+    catch (const std::invalid_argument& e) {
+        std::cout.rdbuf(cout_buffer);
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    std::cout.rdbuf(cout_buffer);
+
+    if (config->output.empty()) {
+        report.write(std::cout, config->format);
+        return 0;
+    }
+    std::ofstream out(config->output);
+    report.write(out, config->format);
+    return out ? 0 : 1;
+}